@@ -32,3 +32,120 @@ BENCHMARK(BM_create_n_actions_with_n_agents)
         ->Unit(benchmark::kMillisecond)
         ->Arg(1<<10)->Arg(1<<15)
 ;
+
+// Steady-state throughput : each agent acts and actions are cleaned every cycle.
+// Pooled actions (arg 1) are recycled, whereas user spawned ones (arg 0) are destroyed.
+static void BM_act_and_step_n_agents(benchmark::State& state) {
+    auto world = opack::create_world();
+    opack::init<MyActuator>(world);
+    opack::init<MyAction>(world).require<MyActuator>();
+    opack::add_actuator<MyActuator, opack::Agent>(world);
+    opack::spawn_n<opack::Agent>(world, state.range(0));
+    auto filter = world.query_builder<>()
+        .term(flecs::IsA).second<opack::Agent>()
+        .term(flecs::Prefab).not_()
+        .build();
+
+    const bool pooled = state.range(1) != 0;
+    for ([[maybe_unused]] auto _ : state)
+    {
+        filter.each(
+            [pooled](flecs::entity e)
+            {
+                auto world = e.world();
+                if (pooled)
+                    opack::act<MyAction>(e);
+                else
+                    opack::act(e, opack::spawn<MyAction>(world));
+            }
+        );
+        opack::step(world);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_act_and_step_n_agents)
+        ->Unit(benchmark::kMillisecond)
+        ->ArgsProduct({ {1 << 10, 1 << 15}, {0, 1} });
+
+// Same as above, with one bulk call instead of one call per agent (arg 0 : act, arg 1 : act_n).
+static void BM_act_n_and_step_n_agents(benchmark::State& state) {
+    auto world = opack::create_world();
+    opack::init<MyActuator>(world);
+    auto prefab = opack::init<MyAction>(world).require<MyActuator>();
+    opack::add_actuator<MyActuator, opack::Agent>(world);
+    opack::spawn_n<opack::Agent>(world, state.range(0));
+    auto filter = world.query_builder<>()
+        .term(flecs::IsA).second<opack::Agent>()
+        .term(flecs::Prefab).not_()
+        .build();
+    std::vector<opack::Entity> agents;
+    filter.each([&agents](flecs::entity e) { agents.push_back(e); });
+
+    const bool bulk = state.range(1) != 0;
+    for ([[maybe_unused]] auto _ : state)
+    {
+        if (bulk)
+            opack::act_n(agents, prefab);
+        else
+            for (auto& agent : agents)
+                opack::act(agent, prefab);
+        opack::step(world);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_act_n_and_step_n_agents)
+        ->Unit(benchmark::kMillisecond)
+        ->ArgsProduct({ {1 << 10, 1 << 15}, {0, 1} });
+
+// Agents act together, two by two : each one joins the pending action left by previous agent, if any.
+static void BM_join_and_step_n_agents(benchmark::State& state) {
+    auto world = opack::create_world();
+    opack::init<MyActuator>(world);
+    auto prefab = opack::init<MyAction>(world).require<MyActuator>().arity(2, 2);
+    opack::add_actuator<MyActuator, opack::Agent>(world);
+    opack::spawn_n<opack::Agent>(world, state.range(0));
+    auto filter = world.query_builder<>()
+        .term(flecs::IsA).second<opack::Agent>()
+        .term(flecs::Prefab).not_()
+        .build();
+    std::vector<opack::Entity> agents;
+    filter.each([&agents](flecs::entity e) { agents.push_back(e); });
+
+    for ([[maybe_unused]] auto _ : state)
+    {
+        for (auto& agent : agents)
+            opack::act(agent, prefab);
+        opack::step(world);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_join_and_step_n_agents)
+        ->Unit(benchmark::kMillisecond)
+        ->Arg(1 << 10)->Arg(1 << 15);
+
+// Steps with n action types having lifecycle callbacks, and one agent acting. Cost should not grow with n.
+static void BM_step_with_n_action_types_callbacks(benchmark::State& state) {
+    auto world = opack::create_world();
+    opack::init<MyActuator>(world);
+    opack::init<MyAction>(world).require<MyActuator>();
+    opack::add_actuator<MyActuator, opack::Agent>(world);
+    auto agent = opack::spawn<opack::Agent>(world);
+    std::size_t calls{ 0 };
+    for (auto i = 0; i < state.range(0); ++i)
+    {
+        auto prefab = world.prefab().is_a<MyAction>();
+        opack::internal::add_action_callback<opack::ActionCallbacks::begin>(world, prefab, [&calls](opack::Entity) { ++calls; });
+        opack::internal::add_action_callback<opack::ActionCallbacks::update>(world, prefab, [&calls](opack::Entity, float) { ++calls; });
+        opack::internal::add_action_callback<opack::ActionCallbacks::end>(world, prefab, [&calls](opack::Entity) { ++calls; });
+    }
+
+    for ([[maybe_unused]] auto _ : state)
+    {
+        opack::act<MyAction>(agent);
+        opack::step(world);
+    }
+    benchmark::DoNotOptimize(calls);
+}
+BENCHMARK(BM_step_with_n_action_types_callbacks)
+        ->Unit(benchmark::kMicrosecond)
+        ->Arg(1)->Arg(50)->Arg(500);
@@ -0,0 +1,74 @@
+#include "../utils.hpp"
+#include <vector>
+
+OPACK_AGENT(MyAgent);
+
+// Each agent sends a message to the next one, then every agent reads its inbox.
+// Messages are found through the messages rule (arg 0) or popped from mailboxes (arg 1).
+static void BM_send_and_receive_with_n_agents(benchmark::State& state) {
+    auto world = opack::create_world();
+    opack::init<MyAgent>(world);
+    if (state.range(1) != 0)
+        opack::add_mailbox<MyAgent>(world);
+    std::vector<opack::Entity> agents;
+    for (auto i = 0; i < state.range(0); ++i)
+        agents.push_back(opack::spawn<MyAgent>(world));
+
+    std::size_t received{ 0 };
+    for ([[maybe_unused]] auto _ : state)
+    {
+        for (std::size_t i = 0; i < agents.size(); ++i)
+            opack::write(agents[i]).receiver(agents[(i + 1) % agents.size()]).send();
+        for (auto& agent : agents)
+            opack::inbox(agent).each([&received](opack::Entity) { ++received; });
+        opack::step(world);
+    }
+    benchmark::DoNotOptimize(received);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_send_and_receive_with_n_agents)
+        ->Unit(benchmark::kMillisecond)
+        ->ArgsProduct({ {1 << 8, 1 << 12}, {0, 1} });
+
+OPACK_MESSAGE(PooledMessage);
+struct Content { int value; };
+
+// Same exchange through mailboxes, each message carrying a payload.
+// Messages are created and destroyed (arg 0) or recycled with payloads in the message arena (arg 1).
+static void BM_send_and_receive_pooled_with_n_agents(benchmark::State& state) {
+    auto world = opack::create_world();
+    opack::init<MyAgent>(world);
+    opack::init<PooledMessage>(world);
+    opack::add_mailbox<MyAgent>(world);
+    const auto pooled = state.range(1) != 0;
+    if (pooled)
+        opack::pool_messages<PooledMessage>(world);
+    std::vector<opack::Entity> agents;
+    for (auto i = 0; i < state.range(0); ++i)
+        agents.push_back(opack::spawn<MyAgent>(world));
+
+    int received{ 0 };
+    for ([[maybe_unused]] auto _ : state)
+    {
+        for (std::size_t i = 0; i < agents.size(); ++i)
+        {
+            auto message = opack::write<PooledMessage>(agents[i]).receiver(agents[(i + 1) % agents.size()]);
+            if (pooled)
+                message.payload<Content>(static_cast<int>(i));
+            else
+                message.set<Content>({ static_cast<int>(i) });
+            message.send();
+        }
+        for (auto& agent : agents)
+            opack::inbox(agent).each([&received, pooled](opack::Entity message)
+                {
+                    received += pooled ? opack::payload<Content>(message)->value : message.get<Content>()->value;
+                });
+        opack::step(world);
+    }
+    benchmark::DoNotOptimize(received);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_send_and_receive_pooled_with_n_agents)
+        ->Unit(benchmark::kMillisecond)
+        ->ArgsProduct({ {1 << 8, 1 << 12}, {0, 1} });
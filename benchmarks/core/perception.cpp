@@ -1,4 +1,7 @@
 #include "../utils.hpp"
+#include <cmath>
+#include <span>
+#include <vector>
 
 OPACK_SUB_PREFAB(MySense, opack::Sense);
 struct MySenseValue {int i{0};};
@@ -44,6 +47,46 @@ BENCHMARK(BM_create_n_percepts_with_m_agents)
         ->Unit(benchmark::kMillisecond)
 		->Ranges({ { 1 << 2, 1 << 5}, {1 << 2, 1 << 5} });
 ;
+
+static void BM_create_n_percepts_with_m_agents_in_bulk(benchmark::State& state) {
+    auto world = opack::create_world();
+    opack::init<MySense>(world);
+    opack::add_sense<MySense, opack::Agent>(world);
+
+    opack::spawn_n<opack::Artefact>(world, state.range(0));
+    opack::spawn_n<opack::Agent>(world, state.range(1));
+
+    auto agent_filter = world.query_builder<>()
+        .term(flecs::IsA).second<opack::Agent>()
+        .term(flecs::Prefab).not_()
+        .build();
+
+    auto artefact_filter = world.query_builder<>()
+        .term(flecs::IsA).second<opack::Artefact>()
+        .term(flecs::Prefab).not_()
+        .build();
+
+    std::vector<opack::Entity> artefacts;
+    artefact_filter.each([&artefacts](flecs::entity artefact) { artefacts.push_back(artefact); });
+
+    for ([[maybe_unused]] auto _ : state)
+    {
+        agent_filter.each(
+            [&artefacts](flecs::entity agent)
+            {
+                opack::perceive_all<MySense>(agent, artefacts);
+            }
+        );
+    }
+}
+BENCHMARK(BM_create_n_percepts_with_m_agents_in_bulk)
+        ->Unit(benchmark::kNanosecond)
+		->Args({1<<0, 1<< 0});
+
+BENCHMARK(BM_create_n_percepts_with_m_agents_in_bulk)
+        ->Unit(benchmark::kMillisecond)
+		->Ranges({ { 1 << 2, 1 << 5}, {1 << 2, 1 << 5} });
+
 static void BM_iterate_n_percepts_with_m_agents(benchmark::State& state) {
     auto world = opack::create_world();
     opack::init<MySense>(world);
@@ -93,6 +136,114 @@ BENCHMARK(BM_iterate_n_percepts_with_m_agents)
         ->Unit(benchmark::kMillisecond)
 		->Ranges({ { 1 << 2, 1 << 5}, {1 << 2, 1 << 5} });
 
+// Same as above, once percepts have been materialised, with a visitor or by chunks.
+static void BM_iterate_n_cached_percepts_with_m_agents(benchmark::State& state) {
+    auto world = opack::create_world();
+    opack::init<MySense>(world);
+    opack::add_sense<MySense, opack::Agent>(world);
+
+    opack::spawn_n<opack::Artefact>(world, state.range(0));
+    opack::spawn_n<opack::Agent>(world, state.range(1));
+
+    auto agent_filter = world.query_builder<>()
+        .term(flecs::IsA).second<opack::Agent>()
+        .term(flecs::Prefab).not_()
+        .build();
+
+    auto artefact_filter = world.query_builder<>()
+        .term(flecs::IsA).second<opack::Artefact>()
+        .term(flecs::Prefab).not_()
+        .build();
+
+	agent_filter.each(
+		[&artefact_filter](flecs::entity agent)
+		{
+			artefact_filter.each(
+				[&agent](flecs::entity artefact)
+				{
+					opack::perceive<MySense>(agent, artefact);
+				}
+			);
+		}
+	);
+    opack::step(world);
+
+    const bool chunked = state.range(2) != 0;
+    for ([[maybe_unused]] auto _ : state)
+    {
+		agent_filter.each(
+			[chunked](flecs::entity agent)
+			{
+                std::size_t count{ 0 };
+                if (chunked)
+                    opack::perception(agent).each_chunk([&count](opack::Entity, std::span<const flecs::entity_t> subjects){ count += subjects.size(); });
+                else
+                    opack::perception(agent).each<opack::Artefact>([&count](opack::Entity){ ++count; });
+                benchmark::DoNotOptimize(count);
+			}
+		);
+    }
+}
+
+BENCHMARK(BM_iterate_n_cached_percepts_with_m_agents)
+        ->Unit(benchmark::kMillisecond)
+		->ArgsProduct({ { 1 << 2, 1 << 5}, {1 << 2, 1 << 5}, {0, 1} });
+
+static void BM_spatial_perception_n_agents(benchmark::State& state) {
+    auto world = opack::create_world();
+    opack::init<MySense>(world).range(5.0f);
+    opack::add_sense<MySense, opack::Agent>(world);
+
+    // Constant density : about one agent per 25 square units.
+    const auto n = state.range(0);
+    const auto side = std::sqrt(static_cast<float>(n) * 25.0f);
+    for (auto i = 0; i < n; i++)
+    {
+        opack::spawn<opack::Agent>(world)
+            .set<opack::Position>({ std::fmod(static_cast<float>(i) * 7.31f, side), std::fmod(static_cast<float>(i) * 3.17f, side) });
+    }
+
+    for ([[maybe_unused]] auto _ : state)
+    {
+        opack::step(world);
+    }
+}
+
+BENCHMARK(BM_spatial_perception_n_agents)
+        ->Unit(benchmark::kMillisecond)
+		->Range(1 << 6, 1 << 14);
+
+static void BM_visibility_perception_n_agents(benchmark::State& state) {
+    auto world = opack::create_world();
+    opack::init<MySense>(world).range(5.0f).field_of_view(2.0f);
+    opack::add_sense<MySense, opack::Agent>(world);
+
+    // Constant density : about one agent per 25 square units, with one opaque cell out of seven.
+    const auto n = state.range(0);
+    const auto side = std::sqrt(static_cast<float>(n) * 25.0f);
+    auto grid = occupancy_grid(static_cast<std::size_t>(side) + 1, static_cast<std::size_t>(side) + 1);
+    for (std::size_t x = 0; x < grid.width(); x++)
+        for (std::size_t y = 0; y < grid.height(); y++)
+            grid.set(x, y, (x * 31 + y * 17) % 7 == 0);
+    world.set<opack::Occlusion>({ grid });
+
+    for (auto i = 0; i < n; i++)
+    {
+        opack::spawn<opack::Agent>(world)
+            .set<opack::Position>({ std::fmod(static_cast<float>(i) * 7.31f, side), std::fmod(static_cast<float>(i) * 3.17f, side) })
+            .set<opack::Heading>({ static_cast<float>(i) });
+    }
+
+    for ([[maybe_unused]] auto _ : state)
+    {
+        opack::step(world);
+    }
+}
+
+BENCHMARK(BM_visibility_perception_n_agents)
+        ->Unit(benchmark::kMillisecond)
+		->Arg(1 << 10)->Arg(1 << 14)->Arg(100000);
+
 static void BM_does_perceive(benchmark::State& state) {
     auto world = opack::create_world();
     opack::init<MySense>(world);
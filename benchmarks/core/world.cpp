@@ -54,6 +54,29 @@ BENCHMARK(BM_spawn_n_agent_in_bulk)
     ->Range(1 << 0, 1 << 20)
 ;
 
+OPACK_SUB_PREFAB(BenchmarkSense, opack::Sense);
+
+// Second argument is the sense storage : 0 without sense, 1 for opack::SenseStorage::entity, 2 for opack::SenseStorage::compact.
+void BM_spawn_n_agent_in_bulk_with_sense(benchmark::State& state) {
+    auto world = opack::create_world();
+    opack::init<BenchmarkSense>(world);
+    if (state.range(1) == 1)
+        opack::add_sense<BenchmarkSense, opack::Agent>(world, opack::SenseStorage::entity);
+    else if (state.range(1) == 2)
+        opack::add_sense<BenchmarkSense, opack::Agent>(world, opack::SenseStorage::compact);
+    const auto prefab = opack::entity<opack::Agent>(world);
+    for ([[maybe_unused]] auto _ : state) {
+        opack::spawn_n(prefab, state.range(0));
+    }
+    // Memory footprint, as number of entities alive.
+    state.counters["entities"] = static_cast<double>(world.count(flecs::Wildcard));
+    state.counters["sense_instances"] = static_cast<double>(world.count(flecs::IsA, opack::entity<BenchmarkSense>(world)));
+}
+BENCHMARK(BM_spawn_n_agent_in_bulk_with_sense)
+    ->Unit(benchmark::kMillisecond)
+    ->ArgsProduct({ { 1 << 10, 1 << 15, 1 << 20 }, { 0, 1, 2 } })
+;
+
 void BM_loop_n_with_m_agents(benchmark::State& state)
 {
 	auto world = opack::create_world();
@@ -54,14 +54,15 @@ void generate_actions_sequence(opack::World& world, const char * filename)
 	auto &[r, g, b] = C;
 
 	std::vector<std::string> tick_labels{};
-	world.filter<const opack::LastActionPrefabs>().each([&r, &g, &b, &tick_labels](opack::Entity actuator, const opack::LastActionPrefabs& memory)
+	world.filter<const opack::TrackedActions>().term(flecs::Prefab).not_().each([&r, &g, &b, &tick_labels](opack::Entity actuator, const opack::TrackedActions&)
 		{
 			auto sub_r = vector_1d{};
 			auto sub_g = vector_1d{};
 			auto sub_b = vector_1d{};
-			for(auto action : memory.previous_prefabs_done)
+			const auto memory = opack::recent_actions(actuator);
+			for(std::size_t i = 0; i < memory.size(); ++i)
 			{
-                auto color = action.get<Color>();
+                auto color = memory.peek(i).get<Color>();
 				sub_r.push_back(color->r);
 				sub_g.push_back(color->g);
 				sub_b.push_back(color->b);
@@ -107,15 +108,16 @@ int main()
         ;
     world.add<Configuration>();
 
-    world.system<const opack::LastActionPrefabs>()
+    world.system<const opack::TrackedActions>()
         .term<InspectMemory>().parent()
         .kind(flecs::PostUpdate)
-        .each([](opack::Entity actuator, const opack::LastActionPrefabs& memory)
+        .each([](opack::Entity actuator, const opack::TrackedActions&)
             {
                 fmt::print("[INSPECTION] - {} has done : [", actuator.parent().name());
-                for(auto& action : memory.previous_prefabs_done)
+                const auto memory = opack::recent_actions(actuator);
+                for(std::size_t i = 0; i < memory.size(); ++i)
                 {
-                    fmt::print("{} -", action.path());
+                    fmt::print("{} -", memory.peek(i).path());
                 }
                 fmt::print("]\n");
             });
@@ -225,16 +227,11 @@ int main()
         [](opack::Entity agent, ActionSelection::inputs& inputs)
         {
         	auto graph = ActionSelection::get_graph(inputs);
-            const auto& actions_done = simple::get_actuator(agent).get<opack::LastActionPrefabs>()->previous_prefabs_done;
+            const auto actions_done = opack::recent_actions(simple::get_actuator(agent));
 			for (auto& a : ActionSelection::get_choices(inputs))
 			{
                 auto color = *a.get<Color>();
-                if(const auto count = std::count_if(actions_done.begin(), actions_done.end(), 
-                                                    [&a](const flecs::entity_view action)
-                                                    {
-	                                                    return action == a;
-                                                    }
-                ); color.r > 0  && count < 2)
+                if(const auto count = actions_done.count(a); color.r > 0  && count < 2)
 					graph.positive_influence(a);
                 else if(color.r > 0  && count >= 2) 
 					graph.negative_influence(a);
@@ -248,12 +245,12 @@ int main()
         [](opack::Entity agent, ActionSelection::inputs& inputs)
         {
         	auto graph = ActionSelection::get_graph(inputs);
-            const auto& actions_done = simple::get_actuator(agent).get<opack::LastActionPrefabs>();
+            const auto actions_done = opack::recent_actions(simple::get_actuator(agent));
 			for (auto& a :  ActionSelection::get_choices(inputs))
 			{
                 auto color = *a.get<Color>();
                 auto c = rgb(color);
-                if (const auto has_done = actions_done->has_done(a); c != ::color::constant::black_t{} && !has_done)
+                if (const auto has_done = actions_done.has_done(a); c != ::color::constant::black_t{} && !has_done)
 					graph.positive_influence(a);
                 else if (has_done)
 					graph.negative_influence(a);
@@ -14,6 +14,7 @@
 #include <opack/core/entity.hpp>
 #include <opack/core/action.hpp>
 #include <opack/core/perception.hpp>
+#include <opack/core/memory.hpp>
 #include <opack/core/communication.hpp>
 #include <opack/core/simulation.hpp>
 #include <opack/core/operation.hpp>
@@ -7,12 +7,17 @@
  *********************************************************************/
 #pragma once
 
+#include <concepts>
 #include <functional>
+#include <span>
+#include <utility>
+#include <vector>
 
 #include <flecs.h>
 
 #include <opack/core/api_types.hpp>
 #include <opack/core/components.hpp>
+#include <opack/utils/flecs_helper.hpp>
 
  /**
  @brief Shorthand for OPACK_SUB_PREFAB(name, opack::Action)
@@ -45,8 +50,17 @@ namespace opack
 	{
 		using Handle::Handle;
 
-		/** Should this actuator track last @c ring_buffer_size previous actions done. */
-		ActuatorHandle& track(std::size_t ring_buffer_size);
+		/**
+		 * Record actions finished with this actuator in @ref ActionHistory, and index last @c size ones of each actuator
+		 * for @ref has_done and @ref last_actions.
+		 */
+		ActuatorHandle& track(std::size_t size);
+
+		/** How this actuator handles a new action while doing another one of same priority. */
+		ActuatorHandle& preemption(Preemption policy);
+
+		/** Actions can wait for this actuator, up to @c capacity of them. Implies @c Preemption::queue. See @ref enqueue. */
+		ActuatorHandle& queue(std::size_t capacity);
 	};
 
 	struct ActionHandleView : HandleView
@@ -68,28 +82,40 @@ namespace opack
 		/** Set action duration by value (in seconds). */
 		ActionHandle& duration(float value);
 
+		/** Set action priority, see @ref Priority. */
+		ActionHandle& priority(std::int32_t value);
+
+		/** Action needs at least @c min initiators to start, and accepts up to @c max of them. See @ref act. */
+		ActionHandle& arity(std::size_t min, std::size_t max);
+
 		/** Called when action is beginning (after delay so).
 		 * First argument is the action entity
 		 * Second argument is the simulation time when it began.
 		 */
-		template<std::derived_from<opack::Action> T>
-		ActionHandle& on_action_begin(std::function<void(Entity)> func);
+		template<std::derived_from<opack::Action> T, std::invocable<Entity> F>
+		ActionHandle& on_action_begin(F&& func);
 
 		/** Called when action has begun and is not finished yet.
 		 * First argument is the action entity
 		 * Second argument is the simulation time when it began.
 		 * Third argument is delta time (last_time since this was called
 		 */
-		template<std::derived_from<opack::Action> T>
-		ActionHandle& on_action_update(std::function<void(Entity, float)> func);
+		template<std::derived_from<opack::Action> T, std::invocable<Entity, float> F>
+		ActionHandle& on_action_update(F&& func);
 
 		/** Called when action has ended
 		 * First argument is the action entity
 		 * Second argument is the simulation time when it began.
 		 * Third argument is delta time (last_time since this was called
 		 */
-		template<std::derived_from<opack::Action> T>
-		ActionHandle& on_action_end(std::function<void(Entity)> func);
+		template<std::derived_from<opack::Action> T, std::invocable<Entity> F>
+		ActionHandle& on_action_end(F&& func);
+
+		/** Called when action has been aborted, either preempted, rejected or cancelled.
+		 * First argument is the action entity
+		 */
+		template<std::derived_from<opack::Action> T, std::invocable<Entity> F>
+		ActionHandle& on_action_cancel(F&& func);
 	};
 
 	/**
@@ -143,6 +169,38 @@ namespace opack
 	template<ActuatorPrefab T>
 	Entity current_action(EntityView entity);
 
+	/**
+	 *@brief View over last actions finished with a tracked actuator, see @ref ActuatorHandle::track.
+	 *
+	 Usage :
+	 @code{.cpp}
+	 auto last = opack::last_actions<MyActuator>(agent);
+	 last.peek(0);
+	 last.has_done(action_prefab);
+	 @endcode
+	 */
+	struct recent_actions
+	{
+		recent_actions(EntityView _actuator);
+
+		/** Number of actions recorded, up to tracking size. */
+		std::size_t size() const { return recent ? recent->count : 0; }
+
+		/** Prefab of @c n th last action, @c 0 being the most recent. Null entity if fewer actions were recorded. */
+		EntityView peek(std::size_t n = 0) const;
+
+		/** Number of times @c action_prefab is among last actions. */
+		std::size_t count(EntityView action_prefab) const;
+
+		bool has_done(EntityView action_prefab) const { return count(action_prefab) > 0; }
+
+		EntityView actuator;
+
+	private:
+		const ActionHistory* history{ nullptr };
+		const ActionHistory::Recent* recent{ nullptr };
+	};
+
 	/**
 	 * Return last @c n th action_prefab done. @c 0 is the most recent value pushed, whereas @c size()-1 is the oldest value..
 	 * If @c actuator do not track actions, the null entity is returned.
@@ -157,14 +215,30 @@ namespace opack
 	EntityView last_action_prefab(EntityView entity, std::size_t n = 0);
 
 	/**
-	 * Return last action_prefab done.
+	 * Return last actions done by @c entity with actuator @c T.
 	 * If @c actuator do not track actions, it will assert.
 	 */
 	template<ActuatorPrefab T>
-	const LastActionPrefabs& last_actions(EntityView entity);
+	recent_actions last_actions(EntityView entity);
+
+	/** Return every action recorded by tracked actuators, see @ref ActuatorHandle::track. */
+	const ActionHistory& action_history(World& world);
 
 	/**
-	 * Return true if @c entity has done @c action_prefab, false otherwise. Only relevant if
+	 *@brief Call @c func with every action recorded so far, then remove them from @ref ActionHistory.
+	 *
+	 *Records are kept until drained, so long simulations should drain them regularly, e.g. to write them out.
+	 *Last actions of actuators are kept. Must not be called from systems.
+	 *Usage:
+	 *@code{.cpp}
+	 opack::drain_action_history(world, [](const opack::ActionHistory& history) { /* ... */ });
+	 *@endcode
+	 */
+	template<std::invocable<const ActionHistory&> F>
+	void drain_action_history(World& world, F&& func);
+
+	/**
+	 * Return true if @c entity has done @c action_prefab among last actions of its actuator, false otherwise. Only relevant if
 	 * @c actuator is tracking actions prefab.
 	 */
 	bool has_done(EntityView entity, EntityView action_prefab);
@@ -193,13 +267,70 @@ namespace opack
 
 	/**
 	@brief @c initiator is now doing @c action.
+	If @c action is a prefab, a pooled instance is used, see @ref Pooled.
+
+	If @c action has an @ref Arity other than one, it is a joint action : @c initiator joins it, and it
+	only starts once @c Arity::min initiators joined. With a prefab, @c initiator joins the last instance
+	still waiting for initiators, or a new one if there is none, so that matching partners costs nothing.
+	@return The action instance being done.
 	*/
-	void act(Entity initiator, Entity action);
+	Entity act(Entity initiator, Entity action);
 
 	/**
-	@brief @c initiator is now doing @c action.
+	@brief @c initiator is now doing an instance of @c action_prefab.
+	Instances are taken from a pool : once finished, they are recycled with their components, instead of being destroyed.
+	@return The action instance being done.
+	*/
+	Entity act(Entity initiator, EntityView action_prefab);
+
+	/**
+	@brief Each of @c initiators is now doing its own instance of @c action_prefab.
+	Instances are taken from the pool of @c action_prefab, missing ones are created at once
+	and changes are batched, instead of calling @ref act for each initiator.
+	Joint actions (see @ref Arity) are shared, so initiators join them one by one as with @ref act.
+	*/
+	void act_n(std::span<const Entity> initiators, EntityView action_prefab);
+
+	/**
+	@brief Each of @c initiators is now doing its own action of type @c T.
+	*/
+	template<ActionPrefab T>
+	void act_n(std::span<const Entity> initiators);
+
+	/**
+	@brief @c initiator intends to do @c action, a prefab or an instance, optionally on @c target.
+	Unlike @ref act, it can be called from multi-threaded systems : intents are buffered per stage
+	and enacted with @ref act during next @c Act::PreUpdate, sorted by initiator, so that
+	results do not depend on threads scheduling. Identical intents are enacted once.
+	@c initiator must come from the current stage (e.g. the system iterator).
+	*/
+	void intend(EntityView initiator, EntityView action, EntityView target = EntityView{});
+
+	/**
+	@brief @c initiator intends to do an action of type @c T, optionally on @c target. See @ref intend.
 	*/
-	void act(Entity initiator, EntityView action_prefab);
+	template<ActionPrefab T>
+	void intend(EntityView initiator, EntityView target = EntityView{});
+
+	/**
+	@brief @c initiator will do @c action, a prefab or an instance, after actions already waiting for the actuator,
+	regardless of priorities and preemption policy. It starts during next @c Act::PreUpdate if actuator is free by then,
+	so that consecutive actions of a plan follow each other without any gap. Actuator must have a queue, see @ref ActuatorHandle::queue.
+	@return The action instance, aborted if queue was full.
+	*/
+	Entity enqueue(Entity initiator, EntityView action);
+
+	/**
+	@brief @c initiator will do an action of type @c T after actions already waiting for the actuator. See @ref enqueue.
+	*/
+	template<ActionPrefab T>
+	ActionHandle enqueue(Entity initiator);
+
+	/**
+	@brief Abort @c action if it is not ended : its actuators stop doing it, and cancel callbacks are called.
+	Actions waiting in an @ref ActionQueue are aborted too.
+	*/
+	void cancel(Entity action);
 
 	/**
 	@brief Returns current action status of @c action.
@@ -208,6 +339,7 @@ namespace opack
 
 	/**
 	@brief Returns supposed duration of action in simulation time (seconds).
+	It does not decrease while the action is running, see @ref remaining_time.
 	*/
 	float duration(EntityView action);
 
@@ -231,65 +363,284 @@ namespace opack
 		return entity;
 	}
 
-	template<std::derived_from<Action> T>
-	void on_action_begin(World& world, std::function<void(Entity)> func)
+	namespace internal
 	{
-		world.system(fmt::format(fmt::runtime("System_OnBegin_{}"), friendly_type_name<T>().c_str()).c_str())
-			.template kind<Act::PreUpdate>()
-			.term(flecs::IsA).template second<T>()
-			.term(ActionStatus::starting)
-			.each([func](flecs::entity action)
+		/**
+		 * Register @c func to be called on @c E for actions inheriting from @c action_prefab.
+		 * @c func is stored once with its own type, so calling it needs neither a new system nor a @c std::function.
+		 */
+		template<ActionCallbacks::Event E, typename F>
+		void add_action_callback(World& world, EntityView action_prefab, F&& func)
+		{
+			using Functor = std::decay_t<F>;
+			auto callbacks = internal::singleton<ActionCallbacks>(world);
+			auto& functor = callbacks->functors.emplace_back(new Functor(std::forward<F>(func)), [](void* f) { delete static_cast<Functor*>(f); });
+			callbacks->registered[E].push_back({ action_prefab.id(), functor.get(), [](void* f, flecs::entity action, [[maybe_unused]] float delta_time)
 				{
-					func(action);
+					if constexpr (E == ActionCallbacks::update)
+						(*static_cast<Functor*>(f))(action, delta_time);
+					else
+						(*static_cast<Functor*>(f))(action);
 				}
-			).template child_of<opack::world::dynamics>();
+			});
+			callbacks->resolved[E].clear();
+		}
 	}
 
-	template<std::derived_from<opack::Action> T>
-	void on_action_update(World& world, std::function<void(Entity, float)> func)
+	template<std::derived_from<Action> T, std::invocable<Entity> F>
+	void on_action_begin(World& world, F&& func)
 	{
-		world.system(fmt::format(fmt::runtime("System_OnUpdate_{}"), friendly_type_name<T>().c_str()).c_str())
-			.template kind<Act::Update>()
-			.term(flecs::IsA).template second<T>()
-			.term(ActionStatus::running)
-			.each([func](flecs::entity entity)
-				{
-					func(entity, entity.delta_time());
-				}
-			).template child_of<opack::world::dynamics>();
+		internal::add_action_callback<ActionCallbacks::begin>(world, opack::entity<T>(world), std::forward<F>(func));
 	}
 
-	template<std::derived_from<opack::Action> T>
-	void on_action_cancel(World& world, std::function<void(Entity)> func)
+	template<std::derived_from<opack::Action> T, std::invocable<Entity, float> F>
+	void on_action_update(World& world, F&& func)
 	{
+		internal::add_action_callback<ActionCallbacks::update>(world, opack::entity<T>(world), std::forward<F>(func));
 	}
 
-	template<std::derived_from<opack::Action> T>
-	void on_action_end(World& world, std::function<void(Entity)> func)
-	{
-		world.system(fmt::format(fmt::runtime("System_OnEnd_{}"), friendly_type_name<T>().c_str()).c_str())
-			.template kind<Act::PostUpdate>()
-			.term(flecs::IsA).template second<T>()
-			.term(ActionStatus::finished)
-			.template term<Token>().self()
-			.each([func](flecs::entity entity)
+	template<std::derived_from<opack::Action> T, std::invocable<Entity> F>
+	void on_action_cancel(World& world, F&& func)
+	{
+		internal::add_action_callback<ActionCallbacks::cancel>(world, opack::entity<T>(world), std::forward<F>(func));
+	}
+
+	template<std::derived_from<opack::Action> T, std::invocable<Entity> F>
+	void on_action_end(World& world, F&& func)
+	{
+		internal::add_action_callback<ActionCallbacks::end>(world, opack::entity<T>(world), std::forward<F>(func));
+	}
+
+	namespace internal
+	{
+		/** True if @c action is alive and neither finished nor aborted. */
+		inline bool is_active(EntityView action)
+		{
+			if (!action.is_alive())
+				return false;
+			const auto status = action.get<ActionStatus>();
+			return status && *status != ActionStatus::finished && *status != ActionStatus::aborted;
+		}
+
+		inline std::int32_t priority(EntityView action)
+		{
+			const auto priority = action.get<Priority>();
+			return priority ? priority->value : 0;
+		}
+
+		/** What happens to a new action asked to an actuator. */
+		enum class Admission { start, reject, enqueue };
+
+		/**
+		 * Arbitrate between current action of @c actuator and new @c action, according to their priorities
+		 * and to actuator @ref PreemptionPolicy. Current action is cancelled if preempted.
+		 */
+		inline Admission admit(Entity actuator, EntityView action)
+		{
+			auto current = actuator.target<Doing>();
+			if (!current || !is_active(current))
+				return Admission::start;
+			const auto current_priority = priority(current);
+			const auto new_priority = priority(action);
+			const auto policy = actuator.get<PreemptionPolicy>();
+			const auto kept = policy && policy->value == Preemption::queue ? Admission::enqueue : Admission::reject;
+			if (new_priority < current_priority)
+				return kept;
+			if (new_priority == current_priority && policy && policy->value != Preemption::replace)
+				return kept;
+			opack::cancel(current);
+			return Admission::start;
+		}
+
+		/**
+		 * Apply @c admission to new @c action of @c initiator : aborted if rejected, or waiting in @c actuator queue.
+		 * Returns false if @c action should start instead.
+		 */
+		inline bool withhold(const Admission admission, Entity actuator, Entity initiator, Entity action)
+		{
+			switch (admission)
+			{
+			case Admission::reject:
+				action
+					.add<By>(initiator)
+					.set<End, Timestamp>({ action.world().time() })
+					.add(ActionStatus::aborted);
+				return true;
+			case Admission::enqueue:
+				opack_assert(actuator.owns<ActionQueue>(), "Actuator {} has no action queue. Did you call `queue(capacity)` on its prefab ?", actuator.path().c_str());
+				if (!const_cast<ActionQueue*>(actuator.get<ActionQueue>())->actions.push({ action.id(), initiator.id() }))
+					return withhold(Admission::reject, actuator, initiator, action);
+				action
+					.add<By>(initiator)
+					.add(ActionStatus::waiting);
+				return true;
+			case Admission::start:
+				break;
+			}
+			return false;
+		}
+
+		/**
+		 * Reuse a finished instance of @c action_prefab, or spawn a new pooled one if none is left.
+		 * Must not be called concurrently.
+		 */
+		inline Entity acquire_action(EntityView action_prefab)
+		{
+			auto world = action_prefab.world();
+			if (auto pool = internal::singleton<ActionPool>(world))
+			{
+				auto& free = pool->free[action_prefab.id()];
+				while (!free.empty())
+				{
+					const auto id = free.back();
+					free.pop_back();
+					if (world.is_alive(id))
+						return world.entity(id);
+				}
+			}
+			return opack::spawn(action_prefab).add<Pooled>();
+		}
+
+		/**
+		 * Reset a finished pooled @c action and give it back to the pool of its prefab.
+		 * Initiators, targets, timestamps and status are cleared, and duration is restored from the prefab.
+		 * Other components are kept as is.
+		 */
+		inline void release_action(Entity action)
+		{
+			const auto prefab = action.target(flecs::IsA);
+			// An aborted action may still be scheduled : its deadline must not expire the restored duration.
+			internal::singleton<Timers>(action.world())->deadlines.erase({ action.id(), action.world().id<Duration>() });
+			if (const auto required = action.get<RequiredActuator>())
+			{
+				for (int i = 0; const auto initiator = action.target<By>(i); ++i)
 				{
-					func(entity);
+					if (!initiator.is_alive())
+						continue;
+					if (auto actuator = initiator.target(required->value); actuator && actuator.has<Doing>(action))
+						actuator.remove<Doing>(action);
 				}
-			).template child_of<opack::world::dynamics>();
+			}
+			action
+				.remove<By>(flecs::Wildcard)
+				.remove<On>(flecs::Wildcard)
+				.remove<Begin, Timestamp>()
+				.remove<End, Timestamp>()
+				.remove<Duration>()
+				.add(ActionStatus::waiting);
+			// Durations are set on prefabs as overrides (see ActionHandle::duration), so each instance needs its own copy.
+			if (const auto duration = prefab.get<Duration>())
+				action.set<Duration>(*duration);
+			internal::singleton<ActionPool>(action.world())->free[prefab.id()].push_back(action.id());
+		}
+
+		/**
+		 * @c initiator joins joint @c action, or an instance of it waiting for initiators if it is a prefab.
+		 * Action is started once @c arity.min initiators joined. An initiator never joins the same instance twice.
+		 * If its actuator does not admit the action, a separate instance is rejected or queued for it, so that
+		 * the shared one is left untouched.
+		 */
+		inline Entity join(Entity initiator, Entity action, const Arity& arity)
+		{
+			auto world = action.world();
+			auto joint = internal::singleton<JointActions>(world);
+			const auto prefab = action.has(flecs::Prefab) ? action : action.target(flecs::IsA);
+			auto& open = joint->open[prefab.id()];
+			const auto is_open = [&world, joint, &arity](const flecs::entity_t id)
+			{
+				const auto joined = joint->joined.find(id);
+				return world.is_alive(id) && joined != joint->joined.end() && joined->second < arity.min && is_active(world.entity(id));
+			};
+
+			Entity effective_action{ action };
+			if (action.has(flecs::Prefab))
+			{
+				effective_action = Entity{};
+				while (!open.empty() && !is_open(open.back()))
+					open.pop_back();
+				// Most recent first, skipping those already joined by this initiator.
+				for (auto id = open.rbegin(); id != open.rend() && !effective_action; ++id)
+				{
+					if (is_open(*id) && !world.entity(*id).has<By>(initiator))
+						effective_action = world.entity(*id);
+				}
+				if (!effective_action)
+				{
+					effective_action = acquire_action(action);
+					effective_action.add(ActionStatus::waiting);
+					joint->joined[effective_action.id()] = 0;
+					open.push_back(effective_action.id());
+				}
+			}
+			else if (!joint->joined.contains(action.id()))
+			{
+				// First initiator of this instance, e.g. once dequeued : partners can find it.
+				joint->joined[action.id()] = 0;
+				open.push_back(action.id());
+			}
+
+			auto actuator = opack::actuator(action.get<RequiredActuator>()->value, initiator).mut(action);
+			if (effective_action.has<By>(initiator) && actuator.has<Doing>(effective_action))
+			{
+				opack_warn("Initiator [{}] already joined action [{}].", initiator.path().c_str(), effective_action.path().c_str());
+				return effective_action;
+			}
+			if (joint->joined[effective_action.id()] >= arity.max)
+			{
+				opack_warn("Initiator [{}] cannot join action [{}], which already has {} initiators.", initiator.path().c_str(), effective_action.path().c_str(), joint->joined[effective_action.id()]);
+				return effective_action;
+			}
+			if (const auto admission = admit(actuator, action); admission != Admission::start)
+			{
+				auto own = acquire_action(prefab);
+				withhold(admission, actuator, initiator, own);
+				return own;
+			}
+
+			auto& joined = joint->joined[effective_action.id()];
+			++joined;
+			effective_action.add<By>(initiator);
+			actuator.add<Doing>(effective_action).add<Token>();
+			if (joined == arity.min)
+			{
+				effective_action
+					.set<Begin, Timestamp>({ world.time() })
+					.add(ActionStatus::starting)
+					.set_doc_name(action.name());
+				if (!open.empty() && open.back() == effective_action.id())
+					open.pop_back();
+			}
+			return effective_action;
+		}
 	}
 
 	// --------------------------------------------------------------------------- 
 	// Definition
 	// --------------------------------------------------------------------------- 
 
-	inline ActuatorHandle& ActuatorHandle::track(std::size_t ring_buffer_size)
+	inline ActuatorHandle& ActuatorHandle::track(std::size_t size)
+	{
+		opack_assert(size > 0, "Tracking size is equal to zero, which is invalid !");
+		// Owned by each actuator, so that its last actions are forgotten when it is removed.
+		set_override<TrackedActions>({ size });
+		return *this;
+	}
+
+	inline ActuatorHandle& ActuatorHandle::preemption(Preemption policy)
 	{
-		opack_assert(ring_buffer_size > 0, "Ring buffer size is equal to zero, which is invalid !");
-		set_override<LastActionPrefabs>( {ring_buffer_size});
+		set<PreemptionPolicy>({ policy });
+		if (policy == Preemption::queue && !has<ActionQueue>())
+			set_override<ActionQueue>({});
 		return *this;
 	}
 
+	inline ActuatorHandle& ActuatorHandle::queue(std::size_t capacity)
+	{
+		opack_assert(capacity > 0, "Queue capacity is equal to zero, which is invalid !");
+		set_override<ActionQueue>({ capacity });
+		return preemption(Preemption::queue);
+	}
+
 	inline ActionHandle& ActionHandle::require(EntityView actuator_prefab)
 	{
 		set<RequiredActuator>({ actuator_prefab });
@@ -309,27 +660,48 @@ namespace opack
 		return *this;
 	}
 
-	template<std::derived_from<opack::Action> T>
-	ActionHandle& ActionHandle::on_action_begin(std::function<void(Entity)> func)
+	inline ActionHandle& ActionHandle::priority(std::int32_t value)
+	{
+		set<Priority>({ value });
+		return *this;
+	}
+
+	inline ActionHandle& ActionHandle::arity(std::size_t min, std::size_t max)
+	{
+		opack_assert(min > 0 && min <= max, "Invalid arity [{}, {}] : 0 < min <= max is expected.", min, max);
+		set<Arity>({ min, max });
+		return *this;
+	}
+
+	template<std::derived_from<opack::Action> T, std::invocable<Entity> F>
+	ActionHandle& ActionHandle::on_action_begin(F&& func)
 	{
 		auto world_ = world();
-		opack::on_action_begin<T>(world_, func);
+		opack::on_action_begin<T>(world_, std::forward<F>(func));
 		return *this;
 	}
 
-	template<std::derived_from<opack::Action> T>
-	ActionHandle& ActionHandle::on_action_update(std::function<void(Entity, float)> func)
+	template<std::derived_from<opack::Action> T, std::invocable<Entity, float> F>
+	ActionHandle& ActionHandle::on_action_update(F&& func)
 	{
 		auto world_ = world();
-		opack::on_action_update<T>(world_, func);
+		opack::on_action_update<T>(world_, std::forward<F>(func));
 		return *this;
 	}
 
-	template<std::derived_from<opack::Action> T>
-	ActionHandle& ActionHandle::on_action_end(std::function<void(Entity)> func)
+	template<std::derived_from<opack::Action> T, std::invocable<Entity> F>
+	ActionHandle& ActionHandle::on_action_end(F&& func)
+	{
+		auto world_ = world();
+		opack::on_action_end<T>(world_, std::forward<F>(func));
+		return *this;
+	}
+
+	template<std::derived_from<opack::Action> T, std::invocable<Entity> F>
+	ActionHandle& ActionHandle::on_action_cancel(F&& func)
 	{
 		auto world_ = world();
-		opack::on_action_end<T>(world_, func);
+		opack::on_action_cancel<T>(world_, std::forward<F>(func));
 		return *this;
 	}
 
@@ -380,6 +752,28 @@ namespace opack
 		return opack::spawn<T>(world);
 	}
 
+	inline recent_actions::recent_actions(EntityView _actuator) : actuator{ _actuator }
+	{
+		history = actuator.world().get<ActionHistory>();
+		if (const auto it = history->recent.find(actuator.id()); it != history->recent.end())
+			recent = &it->second;
+	}
+
+	inline EntityView recent_actions::peek(std::size_t n) const
+	{
+		if (n >= size())
+			return flecs::entity::null();
+		return EntityView(actuator.world(), recent->records.peek(n));
+	}
+
+	inline std::size_t recent_actions::count(EntityView action_prefab) const
+	{
+		if (!recent)
+			return 0;
+		const auto it = recent->prefabs.find(action_prefab.id());
+		return it != recent->prefabs.end() ? it->second : 0;
+	}
+
 	/**
 	 * Return last @c n th action_prefab done. @c 0 is the most recent value pushed, whereas @c size()-1 is the oldest value..
 	 * If @c actuator do not track actions, the null entity is returned.
@@ -387,9 +781,9 @@ namespace opack
 	inline EntityView last_action_prefab(EntityView actuator, std::size_t n)
 	{
 		opack_assert(actuator.is_valid(), "Given actuator is invalid.");
-		if (actuator.has<LastActionPrefabs>())
+		if (actuator.has<TrackedActions>())
 		{
-			return actuator.get<LastActionPrefabs>()->peek(n);
+			return recent_actions(actuator).peek(n);
 		}
 		opack_warn("Actuator [{}] with parent [{}] do not track previous actions.", actuator.path().c_str(), actuator.parent().path().c_str());
 		return flecs::entity::null();
@@ -402,11 +796,24 @@ namespace opack
 	}
 
 	template<ActuatorPrefab T>
-	const LastActionPrefabs& last_actions(EntityView entity)
+	recent_actions last_actions(EntityView entity)
 	{
 		opack_assert(opack::actuator<T>(entity).is_valid(), "Entity {} has no actuator {}.", entity.path().c_str(), type_name_cstr<T>());
-		opack_assert(opack::actuator<T>(entity).template has<LastActionPrefabs>(), "Entity {} with actuator {} has no LastActionsPrefabs. Did you make sure you called 'track' on actuator ?", entity.path().c_str(), type_name_cstr<T>());
-		return *opack::actuator<T>(entity).template get<LastActionPrefabs>();
+		opack_assert(opack::actuator<T>(entity).template has<TrackedActions>(), "Entity {} with actuator {} is not tracking actions. Did you make sure you called 'track' on actuator ?", entity.path().c_str(), type_name_cstr<T>());
+		return recent_actions(opack::actuator<T>(entity));
+	}
+
+	inline const ActionHistory& action_history(World& world)
+	{
+		return *world.get<ActionHistory>();
+	}
+
+	template<std::invocable<const ActionHistory&> F>
+	void drain_action_history(World& world, F&& func)
+	{
+		auto history = internal::singleton<ActionHistory>(world);
+		std::forward<F>(func)(std::as_const(*history));
+		history->clear();
 	}
 
 	inline bool has_done(EntityView entity, EntityView action_prefab)
@@ -414,9 +821,9 @@ namespace opack
 		opack_assert(entity.is_valid(), "Given entity is invalid.");
 		opack_assert(action_prefab.is_valid(), "Given action_prefab is invalid.");
 		const auto actuator = opack::actuator(get_required_actuator(action_prefab), entity);
-		if (actuator.has<LastActionPrefabs>())
+		if (actuator.has<TrackedActions>())
 		{
-			return actuator.get<LastActionPrefabs>()->has_done(action_prefab);
+			return recent_actions(actuator).has_done(action_prefab);
 		}
 		opack_warn("Tried seeing if entity [{}] has done action [{}], but actuator [{}] is not tracking previous actions.", entity.path().c_str(), action_prefab.path().c_str(), actuator.path().c_str());
 		return false;
@@ -449,30 +856,30 @@ namespace opack
 		return opack::actuator<T>(entity).template target<Doing>();
 	}
 
-	inline void act(Entity initiator, EntityView action)
+	inline Entity act(Entity initiator, EntityView action)
 	{
 		opack_assert(initiator.is_valid(), "Given initiator is invalid.");
 		opack_assert(action.is_valid(), "Given action is invalid.");
-		act(initiator, action.mut(initiator));
+		return act(initiator, action.mut(initiator));
 	}
 
-	inline void act(Entity initiator, Entity action)
+	inline Entity act(Entity initiator, Entity action)
 	{
 		opack_assert(initiator.is_valid(), "Given initiator is invalid.");
 		opack_assert(action.is_valid(), "Given action is invalid.");
 		opack_assert(action.has<RequiredActuator>(), "Action {0} has no required actuator set ! Did you call : opack::init<YourAction>(world).require<YourActuator>().", action.path().c_str());
 		opack_assert(action.get<RequiredActuator>()->value.is_valid(), "Action required actuator set is invalid ! Did you call : opack::init<YourAction>(world).require(required_actuator) with a correct actuator ?", action.path().c_str());
 
+		if (const auto arity = action.get<Arity>(); arity && (arity->min > 1 || arity->max > 1))
+			return internal::join(initiator, action, *arity);
+
 		flecs::entity effective_action{ action };
 		if (action.has(flecs::Prefab))
-			effective_action = spawn(action);
+			effective_action = internal::acquire_action(action);
 
 		auto actuator = opack::actuator(action.get<RequiredActuator>()->value, initiator);
-		auto last_action = actuator.template target<Doing>();
-		if (last_action)
-			last_action.mut(action); //TODO Handle cancel
-
-		//TODO Wait / Error on arity not satisfied
+		if (internal::withhold(internal::admit(actuator.mut(action), action), actuator.mut(action), initiator, effective_action.mut(action)))
+			return effective_action;
 
 		effective_action.mut(action)
 			.remove<Begin, Timestamp>()
@@ -483,17 +890,158 @@ namespace opack
 			.set_doc_name(action.name())
 		;
 		actuator.mut(action).template add<Doing>(effective_action).template add<Token>();
+		return effective_action;
 	}
 
 	template<ActionPrefab T>
 	ActionHandle act(Entity initiator)
 	{
 		auto world = initiator.world();
-		auto action = opack::spawn<T>(world);
-		act(initiator, action);
+		auto action = act(initiator, opack::entity<T>(world));
+		return ActionHandle(world, action);
+	}
+
+	inline void act_n(std::span<const Entity> initiators, EntityView action_prefab)
+	{
+		opack_assert(action_prefab.is_valid(), "Given action prefab is invalid.");
+		opack_assert(action_prefab.has(flecs::Prefab), "\"{}\" is not a prefab ! Is it initialized ? (opack::init<T>(world) if it's a type).", action_prefab.path().c_str());
+		opack_assert(action_prefab.has<RequiredActuator>(), "Action {0} has no required actuator set ! Did you call : opack::init<YourAction>(world).require<YourActuator>().", action_prefab.path().c_str());
+		if (initiators.empty())
+			return;
+
+		// Joint actions are shared by initiators, so they are matched one by one.
+		if (const auto arity = action_prefab.get<Arity>(); arity && (arity->min > 1 || arity->max > 1))
+		{
+			for (auto initiator : initiators)
+				act(initiator, action_prefab);
+			return;
+		}
+
+		auto world = action_prefab.world();
+		thread_local std::vector<flecs::entity_t> actions;
+		actions.clear();
+		actions.reserve(initiators.size());
+
+		auto& free = internal::singleton<ActionPool>(world)->free[action_prefab.id()];
+		while (!free.empty() && actions.size() < initiators.size())
+		{
+			if (const auto id = free.back(); world.is_alive(id))
+				actions.push_back(id);
+			free.pop_back();
+		}
+
+		const auto missing = initiators.size() - actions.size();
+		// Bulk creation is only possible outside of systems.
+		if (missing > 0 && !ecs_stage_is_readonly(world) && !world.is_deferred())
+		{
+			const ecs_bulk_desc_t desc
+			{
+				.count = static_cast<int32_t>(missing),
+				.ids =
+				{
+					ecs_pair(EcsIsA, action_prefab),
+					world.entity<Pooled>().id()
+				}
+			};
+			const auto created = ecs_bulk_init(world, &desc);
+			actions.insert(actions.end(), created, created + missing);
+		}
+		else
+		{
+			for (std::size_t i = 0; i < missing; ++i)
+				actions.push_back(opack::spawn(action_prefab).add<Pooled>().id());
+		}
+
+		const auto required = action_prefab.get<RequiredActuator>()->value;
+		const auto now = world.time();
+		// Deferred, so that changes to each action are applied with a single table move.
+		world.defer_begin();
+		for (std::size_t i = 0; i < initiators.size(); ++i)
+		{
+			auto action = world.entity(actions[i]);
+			const auto& initiator = initiators[i];
+			opack_assert(initiator.is_valid(), "Initiator {} is invalid.", i);
+			auto actuator = opack::actuator(required, initiator);
+			if (internal::withhold(internal::admit(actuator, action_prefab), actuator, initiator, action))
+				continue;
+			action
+				.remove<Begin, Timestamp>()
+				.remove<End, Timestamp>()
+				.add<By>(initiator)
+				.set<Begin, Timestamp>({ now })
+				.add(ActionStatus::starting);
+			internal::doc_name<Action>(action, action_prefab.name());
+			actuator.template add<Doing>(action).template add<Token>();
+		}
+		world.defer_end();
+	}
+
+	template<ActionPrefab T>
+	void act_n(std::span<const Entity> initiators)
+	{
+		if (initiators.empty())
+			return;
+		auto world = initiators.front().world();
+		act_n(initiators, opack::entity<T>(world));
+	}
+
+	inline void intend(EntityView initiator, EntityView action, EntityView target)
+	{
+		opack_assert(initiator.is_valid(), "Given initiator is invalid.");
+		opack_assert(action.is_valid(), "Given action is invalid.");
+		auto world = initiator.world();
+		auto& stages = internal::singleton<ActionIntents>(world)->stages;
+		const auto stage = static_cast<std::size_t>(world.get_stage_id());
+		opack_assert(stage < stages.size(), "No intent buffer for stage {}. Was thread count changed during this cycle ?", stage);
+		stages[stage].push_back({ initiator.id(), action.id(), target.id() });
+	}
+
+	template<ActionPrefab T>
+	void intend(EntityView initiator, EntityView target)
+	{
+		auto world = initiator.world();
+		intend(initiator, opack::entity<T>(world), target);
+	}
+
+	inline Entity enqueue(Entity initiator, EntityView action)
+	{
+		opack_assert(initiator.is_valid(), "Given initiator is invalid.");
+		opack_assert(action.is_valid(), "Given action is invalid.");
+		opack_assert(action.has<RequiredActuator>(), "Action {0} has no required actuator set ! Did you call : opack::init<YourAction>(world).require<YourActuator>().", action.path().c_str());
+		auto effective_action = action.has(flecs::Prefab) ? internal::acquire_action(action) : action.mut(initiator);
+		auto actuator = opack::actuator(action.get<RequiredActuator>()->value, initiator);
+		internal::withhold(internal::Admission::enqueue, actuator.mut(initiator), initiator, effective_action);
+		return effective_action;
+	}
+
+	template<ActionPrefab T>
+	ActionHandle enqueue(Entity initiator)
+	{
+		auto world = initiator.world();
+		auto action = enqueue(initiator, opack::entity<T>(world));
 		return ActionHandle(world, action);
 	}
 
+	inline void cancel(Entity action)
+	{
+		opack_assert(action.is_valid(), "Action is invalid.");
+		if (!internal::is_active(action))
+			return;
+		if (const auto required = action.get<RequiredActuator>())
+		{
+			for (int i = 0; const auto initiator = action.target<By>(i); ++i)
+			{
+				if (!initiator.is_alive())
+					continue;
+				if (auto actuator = initiator.target(required->value); actuator && actuator.has<Doing>(action))
+					actuator.mut(action).remove<Doing>(action);
+			}
+		}
+		action
+			.set<End, Timestamp>({ action.world().time() })
+			.add(ActionStatus::aborted);
+	}
+
 	inline ActionStatus action_status(EntityView action)
 	{
 		opack_assert(action.is_valid(), "Action is invalid.\n");
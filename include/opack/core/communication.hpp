@@ -8,11 +8,18 @@
 #pragma once
 
 #include <concepts>
+#include <cstdint>
+#include <deque>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <flecs.h>
 
 #include <opack/core/api_types.hpp>
 #include <opack/core/components.hpp>
+#include <opack/utils/bump_arena.hpp>
 
  /**
  @brief Shorthand for OPACK_SUB_PREFAB(name, opack::Message)
@@ -47,6 +54,98 @@ namespace opack
 	/** Component relation used to indicate a performative. */
 	struct Performative{};
 
+	/**
+	 * Messages delivered to an agent, oldest first, see @ref add_mailbox.
+	 * Stored contiguously : popping only moves @c head, and read entries are dropped once they make up half of the queue.
+	 */
+	struct Mailbox
+	{
+		std::vector<flecs::entity_t> messages;
+		std::size_t head{ 0 };
+
+		[[nodiscard]] bool empty() const { return head == messages.size(); }
+		[[nodiscard]] std::size_t size() const { return messages.size() - head; }
+		[[nodiscard]] flecs::entity_t front() const { return messages[head]; }
+
+		void push(const flecs::entity_t message) { messages.push_back(message); }
+
+		void pop()
+		{
+			if (++head == messages.size())
+			{
+				messages.clear();
+				head = 0;
+			}
+			else if (head >= 32 && head * 2 >= messages.size())
+			{
+				messages.erase(messages.begin(), messages.begin() + static_cast<std::ptrdiff_t>(head));
+				head = 0;
+			}
+		}
+	};
+
+	/**
+	 * Messages published on a channel, oldest first, shared by its subscribers. See @ref MessageHandle::channel.
+	 * Each subscriber only keeps a cursor : the position of the next message it will read.
+	 * Messages are destroyed once every cursor has passed them.
+	 */
+	struct ChannelLog
+	{
+		std::deque<flecs::entity_t> messages;
+		/** Position of the first message of @c messages since the channel was created. */
+		std::uint64_t base{ 0 };
+		/** Per subscriber, position of its next message. */
+		std::unordered_map<flecs::entity_t, std::uint64_t> cursors;
+
+		/** Position of the next message to be published. */
+		[[nodiscard]] std::uint64_t end() const { return base + messages.size(); }
+	};
+
+	/**
+	 * Messages addressed, from systems, to agents with a @ref Mailbox or to channels. Each stage has its own buffer,
+	 * so that threads never write the same memory. They are delivered at the beginning of next cycle.
+	 */
+	struct MailDeliveries
+	{
+		/** Receiver, agent or channel, and message. */
+		using Delivery = std::pair<flecs::entity_t, flecs::entity_t>;
+		std::vector<std::vector<Delivery>> stages{ 1 };
+	};
+
+	/** Consumed messages of prefabs enabled by @ref pool_messages, per prefab, waiting to be reused by @ref write. */
+	struct MessagePool
+	{
+		std::unordered_map<flecs::entity_t, std::vector<flecs::entity_t>> free;
+	};
+
+	/**
+	 * Memory of message payloads, see @ref MessageHandle::payload. Each stage has its own arenas.
+	 * At each end of cycle, @c previous is reset and becomes @c current : a payload lives for the cycle it was
+	 * written in and the next one, so that messages written from systems can be read once merged.
+	 */
+	struct MessageArena
+	{
+		struct Stage
+		{
+			bump_arena current;
+			bump_arena previous;
+		};
+		std::vector<Stage> stages{ 1 };
+		/** Incremented at each end of cycle. */
+		std::uint64_t generation{ 0 };
+	};
+
+	/**
+	 * Relation @c (Payload, T) holding a value of type @c T attached to a message, stored in the @ref MessageArena.
+	 * See @ref MessageHandle::payload. A pair, so that payloads of any type are removed at once from recycled messages.
+	 */
+	struct Payload
+	{
+		const void* value;
+		/** @ref MessageArena::generation when it was written. */
+		std::uint64_t generation;
+	};
+
 	struct MessageHandleView : HandleView
 	{
 		using HandleView::HandleView;
@@ -63,6 +162,21 @@ namespace opack
 
 		MessageHandle& receiver(EntityView receiver);
 
+		/**
+		 * \brief Publish the message on @c channel : it is appended once to the channel log, whatever the number of subscribers.
+		 * Subscribers read it with @ref receive(EntityView, EntityView). It is destroyed once they all have.
+		 */
+		MessageHandle& channel(EntityView channel);
+
+		/**
+		 * \brief Attach a @c T built from @c args, allocated in the @ref MessageArena instead of a component column.
+		 * It can be read with @ref payload(EntityView) until the end of the cycle after the one it was written in.
+		 * Destructor of @c T is never called. Use a regular component for a longer-lived content.
+		 */
+		template<typename T, typename... Args>
+		requires std::is_trivially_destructible_v<T>
+		MessageHandle& payload(Args&&... args);
+
         /**
          * \brief After @c time, it will be deleted.
          * \param time in seconds.
@@ -82,6 +196,35 @@ namespace opack
 	template<typename T>
 	Entity channel(World& world);
 
+	/**
+	 *@brief Messages addressed to agents @c TAgent are delivered directly to their @ref Mailbox.
+	 *
+	 *@ref receive and @ref inbox then pop messages from it, instead of querying every message of the world.
+	 *Messages addressed from systems are delivered at the beginning of next cycle, once they are merged.
+	 *Receivers, consumption and cleaning are left unchanged.
+	 *Usage:
+	 *@code{.cpp}
+	 opack::add_mailbox<MyAgent>(world);
+	 @endcode
+	 */
+	template<std::derived_from<Agent> TAgent>
+	void add_mailbox(World& world);
+
+	/**
+	 *@brief Messages of prefab @c T are recycled once consumed, instead of being destroyed.
+	 *
+	 *@ref write and @ref reply then reuse a consumed message, without its sender, receivers, conversation,
+	 *performative, channels, timestamp, timeouts and payloads. Other components set on it are kept,
+	 *so they must be set again, or removed, before sending.
+	 *A message, or its id, must not be kept once consumed, as it may be another message afterwards.
+	 *Usage:
+	 *@code{.cpp}
+	 opack::pool_messages<MyMessage>(world);
+	 @endcode
+	 */
+	template<std::derived_from<Message> T>
+	void pool_messages(World& world);
+
 	/** Write a message from prefab @c prefab. */
 	MessageHandle write(EntityView sender, EntityView prefab);
 
@@ -99,11 +242,26 @@ namespace opack
 	/** Return a received message, if any (null entity returned otherwise), for @c agent. */
 	MessageHandleView receive(EntityView agent);
 
+	/** @c subscriber will read messages published on @c channel from now on. Must not be called concurrently. */
+	void subscribe(EntityView subscriber, EntityView channel);
+
+	/** @c subscriber stops reading @c channel. Its unread messages can be destroyed. Must not be called concurrently. */
+	void unsubscribe(EntityView subscriber, EntityView channel);
+
+	/** Return next message published on @c channel not read yet by @c subscriber, if any (null entity returned otherwise). */
+	MessageHandleView receive(EntityView subscriber, EntityView channel);
+
+	/** Return the number of messages published on @c channel not read yet by @c subscriber. */
+	size_t unread(EntityView subscriber, EntityView channel);
+
 	/** From @c reader pov, @c message doesn't matter anymore. If every receiver of a @c message
 	 * has consumed the message, it will be discarded. */
 	void consume(EntityView reader, Entity message);
 
 	// ~~~ Getters ~~~
+	/** Payload @c T attached with @ref MessageHandle::payload, or @c nullptr if there is none or it has expired. */
+	template<typename T>
+	const T* payload(EntityView message);
 	EntityView performative(EntityView message);
 	EntityView sender(EntityView message);
 	EntityView conversation_id(EntityView message);
@@ -145,6 +303,12 @@ namespace opack
 		EntityView agent;
 		const queries::Messages& query;
 		flecs::iter_iterable<> iter;
+		/** Set if @c agent has a @ref Mailbox. */
+		Mailbox* mailbox{ nullptr };
+
+	private:
+		/** Drop messages from the front of @c mailbox that are destroyed or already consumed by @c agent. */
+		void skip_stale();
 	};
 
 }
@@ -169,10 +333,46 @@ namespace opack
         return *this;
 	}
 
+	template<typename T, typename... Args>
+	requires std::is_trivially_destructible_v<T>
+	MessageHandle& MessageHandle::payload(Args&&... args)
+	{
+		auto arena = internal::singleton<MessageArena>(world());
+		const auto stage = static_cast<std::size_t>(world().get_stage_id());
+		opack_assert(stage < arena->stages.size(), "No message arena for stage {}. Was thread count changed during this cycle ?", stage);
+		set<Payload, T>({ arena->stages[stage].current.template create<T>(std::forward<Args>(args)...), arena->generation });
+		return *this;
+	}
+
+	template<typename T>
+	const T* payload(EntityView message)
+	{
+		opack_assert(message.is_valid(), "Message is not valid");
+		const auto payload = message.get<Payload, T>();
+		if (!payload)
+			return nullptr;
+		return message.world().get<MessageArena>()->generation - payload->generation <= 1 ? static_cast<const T*>(payload->value) : nullptr;
+	}
+
 	template<typename T>
 	Entity channel(World& world)
 	{
-		return world.entity<T>().add<Channel>();
+		auto channel = world.entity<T>().add<Channel>();
+		if (!channel.has<ChannelLog>())
+			channel.set<ChannelLog>({});
+		return channel;
+	}
+
+	template<std::derived_from<Agent> TAgent>
+	void add_mailbox(World& world)
+	{
+		world.entity<TAgent>().template set_override<Mailbox>({});
+	}
+
+	template<std::derived_from<Message> T>
+	void pool_messages(World& world)
+	{
+		world.entity<T>().template add<Pooled>();
 	}
 
 	template<std::derived_from<Message> T>
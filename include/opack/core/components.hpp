@@ -7,11 +7,20 @@
  *********************************************************************/
 #pragma once
 
+#include <unordered_map>
 #include <unordered_set>
+#include <array>
+#include <compare>
+#include <cstdint>
+#include <memory>
+#include <vector>
 #include <functional>
 
 #include <flecs.h>
+#include <opack/utils/bounded_queue.hpp>
+#include <opack/utils/chunked_vector.hpp>
 #include <opack/utils/ring_buffer.hpp>
+#include <opack/utils/timer_wheel.hpp>
 #include <opack/core/api_types.hpp>
 
 namespace opack
@@ -36,44 +45,221 @@ namespace opack
 	 */
 	struct On {};	
 
+	/**
+	 * Action instances created by @ref act from a prefab, or message prefabs enabled by @ref pool_messages.
+	 * Once finished or consumed, they are reset and recycled instead of destroyed.
+	 */
+	struct Pooled {};
+
+	/** Finished pooled action instances, per action prefab, waiting to be reused by @ref act. */
+	struct ActionPool
+	{
+		std::unordered_map<flecs::entity_t, std::vector<flecs::entity_t>> free;
+	};
+
+	/**
+	 * Actions intended from systems, possibly multi-threaded, and enacted at once during @c Act::PreUpdate.
+	 * Each stage has its own buffer, so that threads never write the same memory. See @ref intend.
+	 */
+	struct ActionIntents
+	{
+		struct Intent
+		{
+			flecs::entity_t initiator;
+			/** Action prefab, or instance. */
+			flecs::entity_t action;
+			/** Added as @c (On, target) to the action, if not null. */
+			flecs::entity_t target;
+			auto operator<=>(const Intent&) const = default;
+		};
+
+		std::vector<std::vector<Intent>> stages{ 1 };
+	};
+
 	/** Indicate which actuator is required for the action. */
 	struct RequiredActuator
 	{
 		flecs::entity_view value;
 	};
 
-	struct LastActionPrefabs
+	/** Actuators with this component have their finished actions recorded in @ref ActionHistory. See @ref ActuatorHandle::track. */
+	struct TrackedActions
 	{
-		LastActionPrefabs(const std::size_t ring_buffer_size = 1) : previous_prefabs_done{ ring_buffer_size }{}
-		ring_buffer<EntityView> previous_prefabs_done;
+		/** Number of last actions indexed per actuator. */
+		std::size_t size{ 1 };
+	};
+
+	/**
+	 * World-level log of actions finished with a tracked actuator, one record per initiator.
+	 * Records are stored column by column, in chunks, so that appending never moves previous ones
+	 * and columns can be visited, or dumped, independently.
+	 */
+	struct ActionHistory
+	{
+		/** Last records of an actuator, and how many times each prefab appears in them. Kept when records are cleared. */
+		struct Recent
+		{
+			Recent(const std::size_t size = 1) : records{ size } {}
+			/** Prefabs of last records, most recent first. */
+			ring_buffer<flecs::entity_t> records;
+			/** Number of valid @c records, up to their size. */
+			std::size_t count{ 0 };
+			std::unordered_map<flecs::entity_t, std::size_t> prefabs;
+		};
 
-        /**
-         * Return last @c n th action_prefab done. @c 0 is the most recent value pushed, whereas @c size()-1 is the oldest value.
-         * Assert if @c n is superior or equal to @c size().
-         */
-		EntityView peek(std::size_t n = 0) const { return previous_prefabs_done.peek(n); }
+		chunked_vector<std::uint64_t> ticks;
+		chunked_vector<flecs::entity_t> initiators;
+		chunked_vector<flecs::entity_t> actuators;
+		chunked_vector<flecs::entity_t> prefabs;
+		chunked_vector<float> durations;
+		/** Per actuator index of its last records. Entries are erased with their actuator. */
+		std::unordered_map<flecs::entity_t, Recent> recent;
 
-		bool has_done(EntityView action_prefab) const { return previous_prefabs_done.contains(action_prefab); }
+		[[nodiscard]] std::size_t size() const { return ticks.size(); }
+
+		/** Remove every record and release their memory. Last actions of actuators are kept. */
+		void clear()
+		{
+			ticks.clear();
+			initiators.clear();
+			actuators.clear();
+			prefabs.clear();
+			durations.clear();
+		}
+
+		/** Append a record, and index it in the @c window last records of @c actuator. */
+		void record(const std::uint64_t tick, const flecs::entity_t initiator, const flecs::entity_t actuator, const flecs::entity_t prefab, const float duration, const std::size_t window)
+		{
+			ticks.push_back(tick);
+			initiators.push_back(initiator);
+			actuators.push_back(actuator);
+			prefabs.push_back(prefab);
+			durations.push_back(duration);
+
+			auto& last = recent.try_emplace(actuator, window).first->second;
+			if (last.count == last.records.size())
+			{
+				const auto evicted = last.records.peek(last.count - 1);
+				if (const auto it = last.prefabs.find(evicted); it != last.prefabs.end() && --it->second == 0)
+					last.prefabs.erase(it);
+			}
+			else
+				++last.count;
+			last.records.push(prefab);
+			++last.prefabs[prefab];
+		}
+	};
+
+	/** How an actuator handles a new action of equal priority while doing another one. */
+	enum class Preemption
+	{
+		/** Current action is aborted, new one starts. */
+		replace,
+		/** New action is aborted. */
+		reject,
+		/** New action waits for current one to end, see @ref ActionQueue. */
+		queue
+	};
+
+	/** Preemption policy of an actuator. Without it, @c Preemption::replace is used. */
+	struct PreemptionPolicy { Preemption value{ Preemption::replace }; };
+
+	/**
+	 * Priority of an action, @c 0 if not set. An action always preempts a lower priority one,
+	 * and is rejected (or queued) by a higher priority one, regardless of @ref PreemptionPolicy.
+	 */
+	struct Priority { std::int32_t value{ 0 }; };
+
+	/**
+	 * Actions waiting for an actuator, first in first out. Next one is started during @c Act::PreUpdate,
+	 * as soon as actuator is not doing anything. When full, new actions are rejected.
+	 */
+	struct ActionQueue
+	{
+		struct Entry
+		{
+			flecs::entity_t action{ 0 };
+			flecs::entity_t initiator{ 0 };
+		};
+
+		ActionQueue(const std::size_t capacity = 8) : actions{ capacity } {}
+		bounded_queue<Entry> actions;
 	};
 
 	/** Indicates the minimum and maximum of entities needed by an action. */
 	struct Arity { std::size_t min{ 1 }; std::size_t max{ 1 };};
 
-	/** Indicates how much time is left, before action is started. */
+	/** Joint actions, with an @ref Arity other than one, that are waiting for initiators. */
+	struct JointActions
+	{
+		/** Number of initiators which joined each joint action not cleaned yet. */
+		std::unordered_map<flecs::entity_t, std::size_t> joined;
+		/** Per action prefab, instances waiting for more initiators to start. Outdated entries are skipped lazily. */
+		std::unordered_map<flecs::entity_t, std::vector<flecs::entity_t>> open;
+	};
+
+	/**
+	 * Action lifecycle callbacks, called by one dispatcher system per event instead of one system per action type.
+	 * See @ref on_action_begin, @ref on_action_update, @ref on_action_end and @ref on_action_cancel.
+	 */
+	struct ActionCallbacks
+	{
+		enum Event : std::size_t { begin, update, end, cancel, count };
+
+		/** User functor, called through a function pointer instantiated with its type. */
+		struct Callback
+		{
+			flecs::entity_t prefab;
+			void* functor;
+			void (*invoke)(void* functor, flecs::entity action, float delta_time);
+		};
+
+		/** Owns registered functors. */
+		std::vector<std::unique_ptr<void, void(*)(void*)>> functors;
+		/** Callbacks per event, in registration order. */
+		std::array<std::vector<Callback>, count> registered;
+		/** Callbacks per event and per action prefab, including those registered on its base prefabs. Filled lazily. */
+		std::array<std::unordered_map<flecs::entity_t, std::vector<Callback>>, count> resolved;
+	};
+
+	/**
+	 * Removed @c value seconds after being set. Adding it without a value doesn't schedule it.
+	 * @c value is not decremented anymore, see @ref remaining_time.
+	 */
 	struct Delay { float value{ 1 }; };
 
+	/** Action is finished @c value seconds after it started running. @c value is not decremented, see @ref remaining_time. */
 	struct Duration { float value{ 0.0 }; };
 
-	/** Removed once value reaches zero. */
+	/**
+	 * Removed @c value seconds after being set, instead of being kept once expired. Adding it without a value doesn't schedule it.
+	 * @c value is not decremented anymore, see @ref remaining_time.
+	 */
 	struct Timer { float value{ 1.0 }; };
 
+	/**
+	 * Location of a tangible entity in a 2D space. Used by spatial perception.
+	 * Write it with @c set, or call @c modified after @c get_mut, so that the spatial index sees the change.
+	 */
+	struct Position
+	{
+		float x{ 0.0f };
+		float y{ 0.0f };
+	};
+
+	/** Direction a tangible entity is facing, in radians, counterclockwise from x axis. Used by visibility perception. */
+	struct Heading
+	{
+		float value{ 0.0f };
+	};
+
 	/** Holds simulation time. */
 	struct Timestamp
 	{
 		float value {0.0f};
 	};
 
-	/** Destroy entity when timeout is equal to zero. */
+	/** Destroy entity @c value cycles (@ref TickTimeout) or seconds (@ref TimeTimeout) after being set. */
 	template<typename T>
 	struct Timeout 
 	{
@@ -82,6 +268,41 @@ namespace opack
 	using TickTimeout = Timeout<size_t>;
 	using TimeTimeout = Timeout<float>;
 
+	/**
+	 * Deadlines of @ref Delay, @ref Timer, timeouts and action @ref Duration, so that only expiring ones are touched each cycle.
+	 * Components are scheduled when set (when action starts running for @ref Duration), values are not updated
+	 * afterwards. Use @ref remaining_time to know how much time is left.
+	 */
+	struct Timers
+	{
+		/** Simulated time, in seconds, of a tick of @c time and @c actions wheels. */
+		static constexpr float resolution{ 0.001f };
+
+		struct Entry
+		{
+			flecs::entity_t entity;
+			flecs::entity_t component;
+			std::uint64_t deadline;
+		};
+
+		struct EntryHash
+		{
+			std::size_t operator()(const std::pair<flecs::entity_t, flecs::entity_t>& key) const
+			{
+				return std::hash<flecs::entity_t>{}(key.first ^ (key.second * 0x9E3779B97F4A7C15ull));
+			}
+		};
+
+		/** Deadlines in simulated time, for @ref Delay, @ref Timer and @ref TimeTimeout. */
+		timer_wheel<Entry> time;
+		/** Deadlines in cycles, for @ref TickTimeout. */
+		timer_wheel<Entry> cycles;
+		/** Deadlines in simulated time, for @ref Duration of running actions. */
+		timer_wheel<Entry> actions;
+		/** Latest deadline per entity and component, so that entries of removed or set again components are ignored. */
+		std::unordered_map<std::pair<flecs::entity_t, flecs::entity_t>, std::uint64_t, EntryHash> deadlines;
+	};
+
 	struct Begin {};
 	struct End {};
 
@@ -0,0 +1,191 @@
+/*****************************************************************//**
+ * \file   memory.hpp
+ * \brief  API to remember subjects after they are not perceived anymore.
+ *
+ * \author Tristan
+ * \date   November 2022
+ *********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <flecs.h>
+#include <opack/core/api_types.hpp>
+#include <opack/core/perception.hpp>
+#include <opack/utils/ring_buffer.hpp>
+
+namespace opack
+{
+	/**
+	 * Last subjects lost by an observer, with the time they were lost, most recent first.
+	 * Bounded : when full, oldest recollection is overwritten. Recollections older than @c lifetime are forgotten.
+	 */
+	struct PerceptMemory
+	{
+		PerceptMemory(const std::size_t capacity = 1, const float _lifetime = 0.0f)
+			: subjects{ capacity }, timestamps{ capacity }, lifetime{ _lifetime } {}
+
+		ring_buffer<flecs::entity_t> subjects;
+		ring_buffer<float> timestamps;
+		float lifetime;
+	};
+
+	/**
+	 * Value of component @c T of subjects in @ref PerceptMemory, as last perceived before they were lost.
+	 * Entries are aligned with @ref PerceptMemory entries.
+	 */
+	template<typename T>
+	struct PerceptSnapshots
+	{
+		PerceptSnapshots(const std::size_t capacity = 1) : values{ capacity } {}
+		ring_buffer<std::optional<T>> values;
+		/** Values of @c T of subjects concealed since last update, taken when they were concealed. */
+		std::vector<std::pair<flecs::entity_t, T>> pending;
+	};
+
+	namespace internal
+	{
+		/** Keep value of @c T of @c subject, concealed by @c observer, if perceivable through @c senses. */
+		template<typename T>
+		void snapshot_concealed(EntityView observer, const flecs::entity_t subject, const std::uint64_t senses)
+		{
+			const auto world = observer.world();
+			const auto snapshots = const_cast<PerceptSnapshots<T>*>(observer.get<PerceptSnapshots<T>>());
+			if (!snapshots || !(senses & perceivable_senses<T>(world)) || !world.is_alive(subject))
+				return;
+			if (const auto value = world.entity(subject).template get<T>())
+				snapshots->pending.emplace_back(subject, *value);
+		}
+
+		/** Push value of @c subject, which has just been lost, to @c snapshots. */
+		template<typename T>
+		void snapshot_lost(PerceptSnapshots<T>& snapshots, const flecs::entity_t subject)
+		{
+			// Most recent snapshot, if it was concealed more than once.
+			const auto it = std::find_if(snapshots.pending.rbegin(), snapshots.pending.rend(), [subject](const auto& pending) { return pending.first == subject; });
+			if (it != snapshots.pending.rend())
+				snapshots.values.push(it->second);
+			else
+				snapshots.values.push(std::nullopt);
+		}
+	}
+
+	/**
+	 *@brief Agents @c TAgent remember, for @c lifetime seconds, up to @c capacity subjects they stopped
+	 *perceiving, with the value of their components @c Ts when last perceived.
+	 *
+	 *A component is only remembered if it was perceivable, see @ref perceive, through a sense perceiving the subject.
+	 *Its value is taken when the subject is concealed, see @ref conceal. Subjects lost otherwise, for example
+	 *because they were destroyed, are remembered without values.
+	 *
+	 *Subjects don't need to stay perceived to be remembered, which keeps sense relations small.
+	 *Memory is updated during @c Perceive::PostUpdate, so @c add_sense must be called before, and only once per agent type.
+	 *Usage:
+	 *@code{.cpp}
+	 opack::add_memory<MyAgent, Position>(world, 32, 10.0f);
+	 //...
+	 opack::memory(agent).value<Position>(subject);
+	 *@endcode
+	 */
+	template<std::derived_from<Agent> TAgent, typename... Ts>
+	void add_memory(World& world, const std::size_t capacity, const float lifetime)
+	{
+		opack::entity<TAgent>(world).template set_override<PerceptMemory>({ capacity, lifetime });
+		(opack::entity<TAgent>(world).template set_override<PerceptSnapshots<Ts>>({ capacity }), ...);
+		// Values are taken when subjects are concealed, as they may change before being materialised as lost.
+		internal::singleton<SenseRegistry>(world)->conceal_hooks.push_back([](EntityView observer, const flecs::entity_t subject, const std::uint64_t senses)
+			{
+				auto world = observer.world();
+				if (observer.has(flecs::IsA, opack::entity<TAgent>(world)))
+					(internal::snapshot_concealed<Ts>(observer, subject, senses), ...);
+			});
+
+		world.system<const Percepts, PerceptMemory, PerceptSnapshots<Ts>...>(fmt::format(fmt::runtime("System_Remember_{}"), friendly_type_name<TAgent>().c_str()).c_str())
+			.template kind<Perceive::PostUpdate>()
+			.term(flecs::IsA).template second<TAgent>()
+			.each([](flecs::entity observer, const Percepts& percepts, PerceptMemory& memory, PerceptSnapshots<Ts>&... snapshots)
+				{
+					const auto world = observer.world();
+					const auto now = world.time();
+					for (const auto id : percepts.lost)
+					{
+						memory.subjects.push(id);
+						memory.timestamps.push(now);
+						(internal::snapshot_lost(snapshots, id), ...);
+					}
+					(snapshots.pending.clear(), ...);
+				}
+			).template child_of<opack::world::dynamics>();
+	}
+
+	/**
+	 *@brief Struct to query what an observer remembers, see @ref add_memory.
+	 *
+	 Usage :
+	 @code{.cpp}
+	 auto m = opack::memory(observer);
+	 m.remembers(subject);
+	 m.last_seen(subject);
+	 m.value<Position>(subject);
+	 @endcode
+	 */
+	struct memory
+	{
+		memory(EntityView _observer) : observer{ _observer } {}
+
+		/** True if @c subject was lost less than @c lifetime seconds ago, and not overwritten since. */
+		bool remembers(EntityView subject) const
+		{
+			return index_of(subject).has_value();
+		}
+
+		/** Time at which @c subject was lost, if it is still remembered. */
+		std::optional<float> last_seen(EntityView subject) const
+		{
+			if (const auto index = index_of(subject))
+				return observer.get<PerceptMemory>()->timestamps[*index];
+			return std::nullopt;
+		}
+
+		/** Value of component @c T of @c subject when last perceived, if remembered. @c nullptr otherwise. */
+		template<typename T>
+		const T* value(EntityView subject) const
+		{
+			const auto snapshots = observer.get<PerceptSnapshots<T>>();
+			const auto index = index_of(subject);
+			if (!snapshots || !index)
+				return nullptr;
+			const auto& snapshot = snapshots->values[*index];
+			return snapshot ? &*snapshot : nullptr;
+		}
+
+		EntityView observer;
+
+	private:
+		/** Position of most recent recollection of @c subject, 0 being the most recent, if not forgotten. */
+		std::optional<std::size_t> index_of(EntityView subject) const
+		{
+			const auto recollections = observer.get<PerceptMemory>();
+			if (!recollections)
+				return std::nullopt;
+			const auto oldest = observer.world().time() - recollections->lifetime;
+			auto timestamp = recollections->timestamps.begin();
+			std::size_t index{ 0 };
+			for (const auto id : recollections->subjects)
+			{
+				// Most recent first, so everything after is older.
+				if (*timestamp < oldest)
+					break;
+				if (id == subject.id())
+					return index;
+				++timestamp;
+				++index;
+			}
+			return std::nullopt;
+		}
+	};
+}
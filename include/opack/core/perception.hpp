@@ -7,11 +7,25 @@
  *********************************************************************/
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <compare>
+#include <numbers>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <unordered_map>
+
 #include <flecs.h>
 #include <opack/core/api_types.hpp>
 #include <opack/core/world.hpp>
 #include <opack/core/entity.hpp>
 #include <opack/utils/flecs_helper.hpp>
+#include <opack/utils/occupancy_grid.hpp>
+#include <opack/utils/spatial_grid.hpp>
 
 /**
 @brief Shorthand for OPACK_SUB_PREFAB(name, opack::Sense)
@@ -33,6 +47,212 @@ namespace opack
 	struct SenseHandle : Handle
 	{
 		using Handle::Handle;
+
+		/** Sense automatically perceives every entity with a @c Position within @c value. */
+		SenseHandle& range(float value);
+
+		/**
+		 * Restrict sense @c range to a view cone of @c angle radians, centered on observer @c Heading,
+		 * and to entities in line of sight, according to @ref Occlusion.
+		 */
+		SenseHandle& field_of_view(float angle);
+
+		/** Automatic perception of this sense (@c range, @c field_of_view) is refreshed @c hz times per second only. */
+		SenseHandle& refresh_rate(float hz);
+	};
+
+	/**
+	 * Maximum distance at which a sense perceives entities with a @c Position.
+	 * Senses with a range are filled automatically during @c Perceive::PreUpdate.
+	 * Set it on a sense prefab with @ref SenseHandle::range, or on a sense instance to override it.
+	 */
+	struct Range
+	{
+		float value{ 0.0f };
+	};
+
+	/**
+	 * Angle, in radians, of the view cone of a sense with a @ref Range.
+	 * Senses with a field of view are filled with entities inside the cone and not hidden behind an opaque cell of @ref Occlusion,
+	 * instead of every entity in range.
+	 */
+	struct FieldOfView
+	{
+		float angle{ 2.0f * std::numbers::pi_v<float> };
+	};
+
+	/**
+	 * Frequency, in Hz, at which automatic perception of a sense is refreshed. Every tick if absent.
+	 * Each observer is offset by a fraction of the period, so that refreshes are spread evenly across ticks.
+	 * Between two refreshes, last perceived subjects are kept.
+	 */
+	struct RefreshRate
+	{
+		float value{ 0.0f };
+	};
+
+	/** Optional singleton describing which cells block line of sight of senses with a @ref FieldOfView. */
+	struct Occlusion
+	{
+		occupancy_grid grid{};
+	};
+
+	/**
+	 * Singleton where automatic perception systems, running on worker threads, stage sense changes.
+	 * One buffer per stage, merged at the end of @c Perceive::PreUpdate, so that senses are up to date during @c Perceive::Update.
+	 */
+	struct PerceptionStaging
+	{
+		struct Change
+		{
+			flecs::entity_t observer;
+			flecs::entity_t sense;
+			flecs::entity_t subject;
+			bool perceive;
+
+			auto operator<=>(const Change&) const = default;
+		};
+
+		std::vector<std::vector<Change>> stages{};
+	};
+
+	/** Singleton indexing entities with a @c Position, updated during @c Perceive::PreUpdate. */
+	struct SpatialIndex
+	{
+		spatial_grid<flecs::entity_t> grid{};
+	};
+
+	/** How subjects perceived through a sense are stored, see @ref add_sense. */
+	enum class SenseStorage
+	{
+		entity,		/**< A sense instance is created as a child of each agent, and holds perceived subjects. Supports @ref Range. */
+		compact		/**< No sense instance, perceived subjects are only stored in agent's @ref Percepts. */
+	};
+
+	/** Bit identifying a sense prefab in @ref Percepts masks, assigned by @ref add_sense. */
+	struct SenseBit
+	{
+		std::uint64_t value{ 0 };
+		bool compact{ false };	/**< True if sense uses @c SenseStorage::compact. */
+	};
+
+	/**
+	 * Components and relations perceivable through a sense prefab, as a dense bitset indexed by
+	 * @ref internal::perceivable_index. Filled by @ref perceive, so that checks are a single bit test.
+	 */
+	struct Perceivables
+	{
+		std::vector<std::uint64_t> words{};
+
+		[[nodiscard]] bool test(const std::size_t index) const
+		{
+			const auto word = index / 64;
+			return word < words.size() && (words[word] >> (index % 64) & 1) != 0;
+		}
+
+		void set(const std::size_t index)
+		{
+			if (const auto word = index / 64; word >= words.size())
+				words.resize(word + 1, 0);
+			words[index / 64] |= std::uint64_t{ 1 } << (index % 64);
+		}
+	};
+
+	/** Called when @ref conceal makes @c observer lose @c subject, with the senses it was perceived through. */
+	using ConcealHook = void(*)(EntityView observer, flecs::entity_t subject, std::uint64_t senses);
+
+	/** Singleton listing sense prefabs by bit index, so that a mask can be mapped back to senses. Up to 64 senses. */
+	struct SenseRegistry
+	{
+		std::vector<flecs::entity_t> senses{};
+		std::uint64_t compact{ 0 };	/**< Bits of senses using @c SenseStorage::compact. */
+		/** Mask of senses through which each @ref internal::perceivable_index is perceivable. Refreshed by @ref add_sense and @ref perceive. */
+		std::vector<std::uint64_t> perceivables{};
+		std::vector<ConcealHook> conceal_hooks{};	/**< See @ref add_memory. */
+	};
+
+	/**
+	 * Subjects perceived by an observer, grouped by sense, materialised once per cycle during @c Perceive::PostUpdate.
+	 * Added to agents with a sense, see @ref add_sense.
+	 *
+	 * While @c dirty is true, perception changed since last materialisation, so @ref perception falls back to rules.
+	 * @c masks are kept up to date by @ref perceive and @ref conceal. Subjects added to or removed from a sense
+	 * instance directly are detected through the instance table, see @ref up_to_date.
+	 */
+	struct Percepts
+	{
+		/** Subjects perceived through @c sense are stored in range [@c begin, @c end) of @c subjects. */
+		struct Span
+		{
+			flecs::entity_t sense;
+			std::uint32_t begin;
+			std::uint32_t end;
+		};
+
+		std::vector<flecs::entity_t> subjects{};
+		std::vector<Span> senses{};
+		std::unordered_map<flecs::entity_t, std::uint64_t> masks{}; /**< @ref SenseBit of each sense perceiving a subject. */
+		std::vector<flecs::entity_t> known{};		/**< Sorted subjects perceived by any sense, at last materialisation. */
+		std::vector<flecs::entity_t> perceived{};	/**< Subjects perceived at last materialisation, but not at the one before. */
+		std::vector<flecs::entity_t> lost{};		/**< Subjects perceived at the materialisation before last, but not anymore. */
+		bool dirty{ true };
+		/** Table of each sense instance at last materialisation : another one means its subjects changed since. */
+		std::vector<std::pair<flecs::entity_t, const ecs_table_t*>> instances{};
+
+		/** True if cache can be used : perception did not change since last materialisation, through the API or not. */
+		[[nodiscard]] bool up_to_date(const flecs::world& world) const
+		{
+			if (dirty)
+				return false;
+			for (const auto& [instance, table] : instances)
+			{
+				if (ecs_get_table(world.c_ptr(), instance) != table)
+					return false;
+			}
+			return true;
+		}
+
+		/** Subjects perceived through sense prefab @c sense. */
+		[[nodiscard]] std::span<const flecs::entity_t> subjects_of(const flecs::entity_t sense) const
+		{
+			for (const auto& span : senses)
+			{
+				if (span.sense == sense)
+					return { subjects.data() + span.begin, subjects.data() + span.end };
+			}
+			return {};
+		}
+
+		/** Mask of senses through which @c subject is perceived, 0 if not perceived. */
+		[[nodiscard]] std::uint64_t mask_of(const flecs::entity_t subject) const
+		{
+			const auto it = masks.find(subject);
+			return it != masks.end() ? it->second : 0;
+		}
+
+		/** Record that @c subject is now perceived through senses in @c bits. */
+		void perceive(const flecs::entity_t subject, const std::uint64_t bits)
+		{
+			masks[subject] |= bits;
+			dirty = true;
+		}
+
+		/**
+		 * Record that @c subject is not perceived anymore through senses in @c bits.
+		 * @return Senses @c subject was perceived through, if it is not perceived anymore. 0 otherwise.
+		 */
+		std::uint64_t conceal(const flecs::entity_t subject, const std::uint64_t bits)
+		{
+			dirty = true;
+			const auto it = masks.find(subject);
+			if (it == masks.end())
+				return 0;
+			const auto previous = it->second;
+			if ((it->second &= ~bits) != 0)
+				return 0;
+			masks.erase(it);
+			return previous;
+		}
 	};
 
 	namespace queries::perception
@@ -82,8 +302,113 @@ namespace opack
 		};
 	}
 
+	namespace internal
+	{
+		/** Call @c func(subject) for each subject perceived through @c sense instance. */
+		template<typename F>
+		void each_subject(EntityView sense, F&& func)
+		{
+			sense.each([&func](flecs::id id)
+				{
+					if (id.is_pair())
+						return;
+					if (const auto subject = id.entity(); !subject.has<flecs::Component>())
+						func(subject);
+				}
+			);
+		}
+
+		/**
+		 * Cached percepts of @c observer, if any.
+		 * Written in place, as a deferred get_mut would only modify a copy.
+		 */
+		inline Percepts* percepts(EntityView observer)
+		{
+			return const_cast<Percepts*>(observer.get<Percepts>());
+		}
+
+		/** Bit of sense prefab @c T, 0 if it has not been added to an agent yet. */
+		template<SensePrefab T>
+		std::uint64_t sense_bit(EntityView entity)
+		{
+			const auto bit = opack::entity<T>(entity.world()).template get<SenseBit>();
+			return bit ? bit->value : 0;
+		}
+
+		inline std::size_t next_perceivable_index()
+		{
+			static std::atomic<std::size_t> counter{ 0 };
+			return counter++;
+		}
+
+		/** Index of type @c T in @ref Perceivables, assigned on first use and shared by all worlds. */
+		template<typename T>
+		std::size_t perceivable_index()
+		{
+			static const auto index = next_perceivable_index();
+			return index;
+		}
+
+		/** True if @c index has been declared perceivable through sense prefab @c sense or one of its bases, see @ref perceive. */
+		inline bool perceivable(EntityView sense, const std::size_t index)
+		{
+			for (; sense; sense = sense.target(flecs::IsA))
+			{
+				if (sense.owns<Perceivables>() && sense.get<Perceivables>()->test(index))
+					return true;
+			}
+			return false;
+		}
+
+		/** True if @c T has been declared perceivable through sense prefab @c sense or one of its bases, see @ref perceive. */
+		template<typename T>
+		bool perceivable(EntityView sense)
+		{
+			return perceivable(sense, perceivable_index<T>());
+		}
+
+		/** Mask of @ref SenseBit of senses through which @c T is perceivable. */
+		template<typename T>
+		std::uint64_t perceivable_senses(const flecs::world& world)
+		{
+			const auto& masks = world.get<SenseRegistry>()->perceivables;
+			const auto index = perceivable_index<T>();
+			return index < masks.size() ? masks[index] : 0;
+		}
+
+		/** Rebuild @c SenseRegistry::perceivables, after senses or their perceivables changed. */
+		void refresh_perceivables(World& world);
+
+		/** Conceal @c subject in @c percepts of @c observer, calling @c SenseRegistry::conceal_hooks if it is lost. */
+		inline void conceal(EntityView observer, Percepts& percepts, const flecs::entity_t subject, const std::uint64_t bits)
+		{
+			if (const auto senses = percepts.conceal(subject, bits))
+			{
+				for (const auto hook : observer.world().get<SenseRegistry>()->conceal_hooks)
+					hook(observer, subject, senses);
+			}
+		}
+
+		/** True if sense prefab @c T uses @c SenseStorage::compact. */
+		template<SensePrefab T>
+		bool is_compact(EntityView entity)
+		{
+			const auto bit = opack::entity<T>(entity.world()).template get<SenseBit>();
+			return bit && bit->compact;
+		}
+	}
+
+	namespace impl
+	{
+		void import_perception(World& world);
+	}
+
 	/**
 	 *@brief Add sense @c T to entity @c prefab
+	 *
+	 *With @c SenseStorage::compact, no entity is created per agent, which makes spawning cheaper,
+	 *but @ref sense can't be called and @ref Range is not supported.
+	 *A sense must use the same storage for every agent.
 	 *Usage:
 	 *@code{.cpp}
 	 OPACK_SUB_PREFAB(MyAgent, opack::Agent)
@@ -93,8 +418,28 @@ namespace opack
 	 *@endcode 
 	 */
 	template<SensePrefab TSense, std::derived_from<Agent> TAgent>
-	void add_sense(World& world)
+	void add_sense(World& world, const SenseStorage storage = SenseStorage::entity)
 	{
+		const bool compact = storage == SenseStorage::compact;
+		if (auto sense = opack::entity<TSense>(world); !sense.template owns<SenseBit>())
+		{
+			auto registry = internal::singleton<SenseRegistry>(world);
+			opack_assert(registry->senses.size() < 64, "Too many senses, up to 64 are supported. Can't add {}.", type_name_cstr<TSense>());
+			const auto bit = std::uint64_t{ 1 } << registry->senses.size();
+			sense.template set<SenseBit>({ bit, compact });
+			registry->senses.push_back(sense);
+			if (compact)
+				registry->compact |= bit;
+			internal::refresh_perceivables(world);
+		}
+		else
+		{
+			opack_assert(sense.template get<SenseBit>()->compact == compact, "Sense {} must use the same storage for every agent.", type_name_cstr<TSense>());
+		}
+		opack::entity<TAgent>(world).template override<Percepts>();
+		if (compact)
+			return;
+
 		// Waiting for fix : https://github.com/SanderMertens/flecs/issues/791
 		// NOTE : also need to template sense !
 		//opack::prefab<TSense>(world)
@@ -113,8 +458,53 @@ namespace opack
 		).template child_of<world::dynamics>();
 	}
 
+	/**
+	 *@brief Call @c func(observer, subject) once per cycle, for each @c observer instance of @c T
+	 *that started perceiving @c subject, with any sense, since last cycle.
+	 *
+	 *Deltas are computed during @c Perceive::PostUpdate, so reasoning only needs to process changes.
+	 *Usage:
+	 *@code{.cpp}
+	 opack::on_perceived<MyAgent>(world, [](opack::Entity observer, opack::Entity subject){});
+	 *@endcode
+	 */
+	template<std::derived_from<Agent> T>
+	void on_perceived(World& world, std::function<void(Entity, Entity)> func)
+	{
+		world.system<const Percepts>(fmt::format(fmt::runtime("System_OnPerceived_{}"), friendly_type_name<T>().c_str()).c_str())
+			.template kind<Perceive::PostUpdate>()
+			.term(flecs::IsA).template second<T>()
+			.each([func](flecs::entity observer, const Percepts& percepts)
+				{
+					for (const auto subject : percepts.perceived)
+						func(observer, observer.world().entity(subject));
+				}
+			).template child_of<opack::world::dynamics>();
+	}
+
+	/**
+	 *@brief Call @c func(observer, subject) once per cycle, for each @c observer instance of @c T
+	 *that stopped perceiving @c subject, with every sense, since last cycle.
+	 *
+	 *@c subject may not be alive anymore, if its destruction is the reason it was lost.
+	 */
+	template<std::derived_from<Agent> T>
+	void on_lost(World& world, std::function<void(Entity, Entity)> func)
+	{
+		world.system<const Percepts>(fmt::format(fmt::runtime("System_OnLost_{}"), friendly_type_name<T>().c_str()).c_str())
+			.template kind<Perceive::PostUpdate>()
+			.term(flecs::IsA).template second<T>()
+			.each([func](flecs::entity observer, const Percepts& percepts)
+				{
+					for (const auto subject : percepts.lost)
+						func(observer, observer.world().entity(subject));
+				}
+			).template child_of<opack::world::dynamics>();
+	}
+
 	/**
 	 * @brief Retrieve instanced sense @c T for current entity.
+	 * Senses using @c SenseStorage::compact have no instance.
 	 *
 	 * WARNING : If you want to retrieve the sense prefab, identified by
 	 * @c T, use @ref entity<T>.
@@ -130,6 +520,8 @@ namespace opack
 	@brief @c T sense is now able to perceive @c U component.
 	@return entity of @c U component;
 
+	Sub senses inherit perceivables of their base.
+
     Usage:
     @code{.cpp}
     opack::perceive<MySense, MyData, MyOtherData, ...>(world);
@@ -138,7 +530,63 @@ namespace opack
 	template<std::derived_from<Sense> T = Sense, typename... Us>
 	Entity perceive(World& world)
 	{
-		return (opack::entity<T>(world).template add<Sense, Us>(), ...);
+		auto sense = opack::entity<T>(world);
+		// Only own perceivables are stored, inherited ones are resolved through bases.
+		auto perceivables = sense.template owns<Perceivables>() ? *sense.template get<Perceivables>() : Perceivables{};
+		(perceivables.set(internal::perceivable_index<Us>()), ...);
+		sense.template set<Perceivables>(perceivables);
+		internal::refresh_perceivables(world);
+		return (sense.template add<Sense, Us>(), ...);
+	}
+
+	namespace internal
+	{
+		/**
+		 * Add (or remove if @c Add is false) subjects in [@c first, @c last), projected with @c proj,
+		 * to senses @c T of @c observer. Senses are resolved once for the whole range.
+		 */
+		template<bool Add, SensePrefab ... T, typename It, typename Proj>
+		void update_senses(EntityView observer, It first, It last, Proj&& proj)
+		{
+			// Null for compact senses, which are only stored in percepts.
+			auto senses = std::array{ (is_compact<T>(observer) ? Entity{} : opack::sense<T>(observer))... };
+			const auto bits = (sense_bit<T>(observer) | ...);
+			const auto percepts = internal::percepts(observer);
+			for (; first != last; ++first)
+			{
+				const flecs::entity_t subject = proj(*first);
+				for (auto& sense : senses)
+				{
+					if (!sense)
+						continue;
+					if constexpr (Add)
+						sense.add(subject);
+					else
+						sense.remove(subject);
+				}
+				if (percepts)
+				{
+					if constexpr (Add)
+						percepts->perceive(subject, bits);
+					else
+						internal::conceal(observer, *percepts, subject, bits);
+				}
+			}
+		}
+
+		template<bool Add, SensePrefab ... T>
+		void update_senses(World& world, std::span<const std::pair<Entity, Entity>> pairs)
+		{
+			world.defer_begin();
+			for (auto first = pairs.begin(); first != pairs.end();)
+			{
+				const auto observer = first->first;
+				const auto last = std::find_if(first, pairs.end(), [observer](const auto& pair) { return pair.first != observer; });
+				update_senses<Add, T...>(observer, first, last, [](const auto& pair) { return pair.second.id(); });
+				first = last;
+			}
+			world.defer_end();
+		}
 	}
 
 	/**
@@ -152,7 +600,7 @@ namespace opack
 	template<SensePrefab ... T>
 	void perceive(EntityView observer, EntityView subject)
 	{
-		(opack::sense<T>(observer).add(subject), ...);
+		internal::update_senses<true, T...>(observer, &subject, &subject + 1, [](EntityView e) { return e.id(); });
 	}
 
 	/**
@@ -161,7 +609,83 @@ namespace opack
 	template<SensePrefab ...T>
 	void conceal(EntityView observer, EntityView subject)
 	{
-		(opack::sense<T>(observer).remove(subject), ...);
+		internal::update_senses<false, T...>(observer, &subject, &subject + 1, [](EntityView e) { return e.id(); });
+	}
+
+	/**
+	@brief @c observer is now able to perceive each of @c subjects through @c T sense.
+
+	Senses are resolved once, and changes are applied in a single deferred block,
+	so that commands on each sense instance are merged. Prefer it to @ref perceive when refreshing many subjects.
+
+    Usage:
+    @code{.cpp}
+    opack::perceive_all<MySense>(observer, subjects);
+    @endcode
+	*/
+	template<SensePrefab ... T>
+	void perceive_all(EntityView observer, std::span<const Entity> subjects)
+	{
+		auto world = observer.world();
+		world.defer_begin();
+		internal::update_senses<true, T...>(observer, subjects.begin(), subjects.end(), [](const Entity& subject) { return subject.id(); });
+		world.defer_end();
+	}
+
+	/**
+	@brief For each pair, @c pair.first is now able to perceive @c pair.second through @c T sense.
+
+	Consecutive pairs with the same observer share sense lookups, so sort them by observer when possible.
+	*/
+	template<SensePrefab ... T>
+	void perceive_all(World& world, std::span<const std::pair<Entity, Entity>> pairs)
+	{
+		internal::update_senses<true, T...>(world, pairs);
+	}
+
+	/**
+	@brief @c observer is now not able to perceive each of @c subjects through @c T sense.
+	*/
+	template<SensePrefab ... T>
+	void conceal_all(EntityView observer, std::span<const Entity> subjects)
+	{
+		auto world = observer.world();
+		world.defer_begin();
+		internal::update_senses<false, T...>(observer, subjects.begin(), subjects.end(), [](const Entity& subject) { return subject.id(); });
+		world.defer_end();
+	}
+
+	/**
+	@brief For each pair, @c pair.first is now not able to perceive @c pair.second through @c T sense.
+	*/
+	template<SensePrefab ... T>
+	void conceal_all(World& world, std::span<const std::pair<Entity, Entity>> pairs)
+	{
+		internal::update_senses<false, T...>(world, pairs);
+	}
+
+	inline SenseHandle& SenseHandle::range(const float value)
+	{
+		opack_assert(value > 0.0f, "Range of sense {} must be strictly positive.", path().c_str());
+		set<Range>({ value });
+		// Cells as large as the largest range, so a query never visits more than 3x3 cells.
+		if (auto index = world().get_mut<SpatialIndex>(); index->grid.cell_size() < value)
+			index->grid.rebuild(value);
+		return *this;
+	}
+
+	inline SenseHandle& SenseHandle::field_of_view(const float angle)
+	{
+		opack_assert(angle > 0.0f, "Field of view of sense {} must be strictly positive.", path().c_str());
+		set<FieldOfView>({ angle });
+		return *this;
+	}
+
+	inline SenseHandle& SenseHandle::refresh_rate(const float hz)
+	{
+		opack_assert(hz > 0.0f, "Refresh rate of sense {} must be strictly positive.", path().c_str());
+		set<RefreshRate>({ hz });
+		return *this;
 	}
 
 	/**
@@ -186,16 +710,19 @@ namespace opack
 
         If no sense type is specified, it defaults to @c opack::Sense.
         Which means it asks, whether the observer perceive @c subject, with any sense.
-        In order to do so, a more complex call is required, which is more expensive.
-        When possible, you should specify a sense.
+        Senses perceiving @c subject are looked up in @ref Percepts masks, then each of them is checked.
 		 */
 		template<std::derived_from<Sense> T = opack::Sense>
 	    bool perceive(EntityView subject) const
         {
 			if constexpr (!std::same_as<T, opack::Sense>)
+			{
+				if (internal::is_compact<T>(observer))
+					return (mask_of(subject) & internal::sense_bit<T>(observer)) != 0;
 				return opack::sense<T>(observer).has(subject);
+			}
 			else
-				return false;
+				return mask_of(subject) != 0;
 		}
 
 		/**
@@ -204,23 +731,21 @@ namespace opack
 
         If no sense type is specified, it defaults to @c opack::Sense.
         Which means it asks, whether the observer perceive @c subject, with any sense.
-        In order to do so, a more complex call is required, which is more expensive.
-        When possible, you should specify a sense.
+        Senses perceiving @c subject are looked up in @ref Percepts masks, then each of them is checked.
 		 */
 		template<std::derived_from<Sense> T = opack::Sense, typename C>
 	    bool perceive(EntityView subject) const
         {
 			if constexpr (!std::same_as<T, opack::Sense>)
 			{
-                if (!opack::sense<T>(observer).template has<Sense, C>())
+                if (!internal::perceivable<C>(opack::entity<T>(observer.world())))
                     return false;
 				return perceive<T>(subject) && subject.has<C>();
 			}
 			else
 			{
-				//TODO
+				return subject.has<C>() && any_sense(mask_of(subject), [](EntityView sense) { return internal::perceivable<C>(sense); });
 			}
-		    return false;
 		}
 
 		/**
@@ -229,23 +754,21 @@ namespace opack
 
         If no sense type is specified, it defaults to @c opack::Sense.
         Which means it asks, whether the observer perceive @c subject, with any sense.
-        In order to do so, a more complex call is required, which is more expensive.
-        When possible, you should specify a sense.
+        Senses perceiving @c subject are looked up in @ref Percepts masks, then each of them is checked.
 		 */
 		template<std::derived_from<Sense> T = opack::Sense>
 	    bool perceive(EntityView subject, EntityView object) const
         {
 			if constexpr (!std::same_as<T, opack::Sense>)
 			{
-                if (!opack::sense<T>(observer).template has<Sense>(object))
+                if (!sense_of<T>().template has<Sense>(object))
                     return false;
 				return perceive<T>(subject) && subject.has(object);
 			}
 			else
 			{
-			    //TODO 	    
+				return subject.has(object) && any_sense(mask_of(subject), [&object](EntityView sense) { return sense.has<Sense>(object); });
 			}
-		    return false;
         }
 
 		/**
@@ -255,15 +778,14 @@ namespace opack
 
         If no sense type is specified, it defaults to @c opack::Sense.
         Which means it asks, whether the observer perceive @c subject, with any sense.
-        In order to do so, a more complex call is required, which is more expensive.
-        When possible, you should specify a sense.
+        Senses perceiving @c subject are looked up in @ref Percepts masks, then each of them is checked.
 		 */
 		template<std::derived_from<Sense> T = opack::Sense, typename R>
 	    bool perceive(EntityView subject, EntityView object) const
         {
 			if constexpr (!std::same_as<T, opack::Sense>)
 			{
-                if (!opack::sense<T>(observer).template has<Sense, R>())
+                if (!internal::perceivable<R>(opack::entity<T>(observer.world())))
                     return false;
 			    if (opack::is_a<Artefact>(object) || opack::is_a<Agent>(object))
 					return perceive<T>(subject) && perceive<T>(object) && subject.has<R>(object);
@@ -271,9 +793,14 @@ namespace opack
 			}
 			else
 			{
-		        //TODO 	    
+				if (!subject.has<R>(object))
+					return false;
+				auto mask = mask_of(subject);
+				// Relation must be perceived through a sense that also perceives object.
+				if (opack::is_a<Artefact>(object) || opack::is_a<Agent>(object))
+					mask &= mask_of(object);
+				return any_sense(mask, [](EntityView sense) { return internal::perceivable<R>(sense); });
 			}
-		    return false;
 		}
 
 		/**
@@ -282,8 +809,7 @@ namespace opack
 
         If no sense type is specified, it defaults to @c opack::Sense.
         Which means it asks, whether the observer perceive @c subject, with any sense.
-        In order to do so, a more complex call is required, which is more expensive.
-        When possible, you should specify a sense.
+        Senses perceiving @c subject are looked up in @ref Percepts masks, then each of them is checked.
 		 */
 		template<std::derived_from<Sense> T = opack::Sense, typename C>
 	    const C* value(EntityView subject) const
@@ -295,49 +821,191 @@ namespace opack
 			}
 			else
 			{
-		        //TODO 	    
+				if (perceive<opack::Sense, C>(subject))
+					return subject.get<C>();
 			}
 		    return nullptr;
 		}
 
-		//TODO Handle at compile time if T is a prefab or tag
-		template<typename T>
-		void each(std::function<void(Entity, const T*)> func)
-		{
-		     auto query = observer.world().get<opack::queries::perception::Entity>();
-             query->rule.iter()
-                .set_var(query->observer_var, observer)
-            .each(
-                [&func](flecs::iter& it, size_t index)
-                {
-                    auto subject = it.entity(index);
-					if (opack::is_a<T>(subject))
-						func(subject, nullptr);
-					else if (subject.has<T>())
-						func(subject, subject.get<T>());
-                }
-			 );
+		/**
+		 *@brief Subjects perceived through sense @c T, as materialised during last @c Perceive::PostUpdate.
+		 *Empty if percepts were never materialised.
+		 */
+		template<SensePrefab T>
+		std::span<const flecs::entity_t> subjects() const
+		{
+			if (const auto percepts = observer.get<Percepts>())
+				return percepts->subjects_of(observer.world().id<T>());
+			return {};
 		}
 
-		template<typename T>
-		void each(std::function<void(Entity)> func)
-		{
-		     auto query = observer.world().get<opack::queries::perception::Entity>();
-             query->rule.iter()
-                .set_var(query->observer_var, observer)
-            .each(
-                [&func](flecs::iter& it, size_t index)
-                {
-                    auto subject = it.entity(index);
-					if (opack::is_a<T>(subject))
-						func(subject);
-					else if (subject.has<T>())
+		/**
+		 *@brief Call @c func for each perceived subject that is an instance of prefab @c T, or that has component @c T.
+		 *@c func is either @c func(subject), or @c func(subject, value), with @c value a pointer to component @c T,
+		 *which is @c nullptr for instances of prefab @c T and for tags.
+		 *Dispatched at compile time, so that @c func can be inlined : sub prefabs are only checked with @ref is_a,
+		 *components holding data only with @c has. Other empty types may be either a prefab or a tag, so both are checked.
+		 */
+		template<typename T, typename F>
+		void each(F&& func) const
+		{
+			each_subject([&func](Entity subject)
+				{
+					const T* value{ nullptr };
+					if constexpr (SubPrefab<T>)
+					{
+						if (!opack::is_a<T>(subject))
+							return;
+					}
+					else if constexpr (std::is_empty_v<T>)
+					{
+						if (!opack::is_a<T>(subject) && !subject.has<T>())
+							return;
+					}
+					else
+					{
+						value = subject.get<T>();
+						if (!value)
+							return;
+					}
+
+					if constexpr (std::is_invocable_v<F&, Entity, const T*>)
+						func(subject, value);
+					else
 						func(subject);
-                }
-			 );
+				}
+			);
+		}
+
+		/**
+		 *@brief Call @c func(sense, subjects) for each contiguous chunk of perceived subjects, without any filtering.
+		 *Chunks are spans of @ref Percepts, one per sense, or each table matched by @c queries::perception::Entity when percepts are outdated.
+		 *Meant for consumers processing subjects in batches.
+		 */
+		template<typename F>
+		void each_chunk(F&& func) const
+		{
+			auto world = observer.world();
+			const auto percepts = observer.get<Percepts>();
+			if (percepts && percepts->up_to_date(world))
+			{
+				for (const auto& span : percepts->senses)
+					func(world.entity(span.sense), std::span<const flecs::entity_t>{ percepts->subjects.data() + span.begin, percepts->subjects.data() + span.end });
+				return;
+			}
+
+			auto query = world.get<opack::queries::perception::Entity>();
+			query->rule.iter()
+				.set_var(query->observer_var, observer)
+				.iter(
+					[&func, &query](flecs::iter& it)
+					{
+						func(it.get_var(query->sense_var), std::span<const flecs::entity_t>{ it.c_ptr()->entities, static_cast<std::size_t>(it.count()) });
+					}
+			);
+
+			if (!percepts)
+				return;
+			const auto registry = world.get<SenseRegistry>();
+			thread_local std::vector<flecs::entity_t> subjects;
+			for (auto bits = registry->compact; bits; bits &= bits - 1)
+			{
+				subjects.clear();
+				const auto bit = bits & (~bits + 1);
+				for (const auto& [subject, mask] : percepts->masks)
+				{
+					if (mask & bit && opack::is_a<Tangible>(world.entity(subject)))
+						subjects.push_back(subject);
+				}
+				if (!subjects.empty())
+					func(world.entity(registry->senses[std::countr_zero(bits)]), std::span<const flecs::entity_t>{ subjects });
+			}
 		}
 
 		EntityView observer;
+
+	private:
+		/** Sense instance of @c T, or sense prefab for compact senses, to look up what @c T perceives. */
+		template<SensePrefab T>
+		Entity sense_of() const
+		{
+			if (internal::is_compact<T>(observer))
+				return opack::entity<T>(observer.world());
+			return opack::sense<T>(observer);
+		}
+
+		/** Mask of @ref SenseBit of senses through which @c subject is perceived. */
+		std::uint64_t mask_of(EntityView subject) const
+		{
+			const auto percepts = observer.get<Percepts>();
+			if (percepts && percepts->up_to_date(observer.world()))
+				return percepts->mask_of(subject);
+
+			// Cache is missing or sense instances were edited directly, so look at each of them. Compact senses have none.
+			std::uint64_t mask{ percepts ? percepts->mask_of(subject) & observer.world().get<SenseRegistry>()->compact : 0 };
+			observer.each([&mask, &subject](flecs::id id)
+				{
+					if (!id.is_pair())
+						return;
+					if (const auto bit = id.first().get<SenseBit>(); bit && id.second().has(subject))
+						mask |= bit->value;
+				}
+			);
+			return mask;
+		}
+
+		/** True if @c predicate(sense) is true for at least one sense prefab in @c mask. */
+		template<typename F>
+		bool any_sense(std::uint64_t mask, F&& predicate) const
+		{
+			if (!mask)
+				return false;
+			auto world = observer.world();
+			const auto& senses = world.get<SenseRegistry>()->senses;
+			for (; mask; mask &= mask - 1)
+			{
+				if (predicate(world.entity(senses[std::countr_zero(mask)])))
+					return true;
+			}
+			return false;
+		}
+
+		/** Scan cached percepts when up to date, otherwise evaluate @c queries::perception::Entity. */
+		template<typename F>
+		void each_subject(F&& func) const
+		{
+			auto world = observer.world();
+			const auto percepts = observer.get<Percepts>();
+			if (percepts && percepts->up_to_date(world))
+			{
+				for (const auto subject : percepts->subjects)
+					func(world.entity(subject));
+				return;
+			}
+
+			auto query = world.get<opack::queries::perception::Entity>();
+			query->rule.iter()
+				.set_var(query->observer_var, observer)
+				.each(
+					[&func](flecs::iter& it, size_t index)
+					{
+						func(it.entity(index));
+					}
+			);
+
+			// Compact senses have no instance for the rule to match, once per sense like above.
+			if (const auto compact = world.get<SenseRegistry>()->compact; percepts && compact)
+			{
+				for (const auto& [id, mask] : percepts->masks)
+				{
+					const auto subject = world.entity(id);
+					if (!opack::is_a<Tangible>(subject))
+						continue;
+					for (auto i = std::popcount(mask & compact); i > 0; --i)
+						func(subject);
+				}
+			}
+		}
 	};
 
     //template<typename R = void, std::derived_from<Sense> T = opack::Sense>
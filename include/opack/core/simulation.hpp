@@ -61,6 +61,20 @@ namespace opack {
     /** Returns total elapsed simulation time. */
     float time(const World& world);
 
+    /**
+    @brief Return simulation time (seconds) left before component @c component of @c entity expires.
+    @c component must be @ref Delay, @ref Timer, @ref TimeTimeout or @ref Duration, whose values are not decremented.
+    Returns 0 if it is not scheduled, e.g. an action that is not running yet.
+    */
+    float remaining_time(EntityView entity, flecs::entity_t component);
+
+    /** Return simulation time (seconds) left before component @c T of @c entity expires. */
+    template<typename T>
+    float remaining_time(EntityView entity)
+    {
+        return remaining_time(entity, entity.world().id<T>());
+    }
+
     /** Imports a module @c T and return corresponding entity. */
     template<typename T>
     Entity import(World& world)
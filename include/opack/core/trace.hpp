@@ -0,0 +1,64 @@
+/*****************************************************************//**
+ * \file   trace.hpp
+ * \brief  API to stream actions beginnings and endings to a binary file,
+ * for offline replay and analysis.
+ *
+ * \author Tristan
+ * \date   November 2022
+ *********************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+#include <flecs.h>
+#include <opack/core/api_types.hpp>
+#include <opack/utils/trace_file.hpp>
+
+namespace opack
+{
+	/**
+	 * Beginning or ending of an action, for one of its initiators.
+	 * Entities are stored as ids of the traced world.
+	 */
+	struct ActionTraceRecord
+	{
+		/** Simulation time. */
+		float timestamp;
+		/** @ref ActionStatus of the action : @c starting, @c finished or @c aborted. */
+		std::uint32_t status;
+		std::uint64_t action;
+		std::uint64_t initiator;
+		std::uint64_t prefab;
+	};
+
+	/** Trace being written, see @ref trace_actions. */
+	struct ActionTraceSink
+	{
+		std::shared_ptr<trace_writer<ActionTraceRecord>> writer;
+	};
+
+	/** Records of a trace file, mapped in memory. See @ref trace_actions. */
+	using action_trace = trace_reader<ActionTraceRecord>;
+
+	/**
+	 *@brief Stream every beginning and ending of actions to binary file @c path, until @ref stop_trace is called.
+	 *
+	 *Records are written by a background thread, so that the simulation does not wait for the disk.
+	 *Calling it again closes the current trace and starts a new one.
+	 *Not included by @c opack/core.hpp, as it is only needed to trace.
+	 *Usage:
+	 *@code{.cpp}
+	 opack::trace_actions(world, "actions.trace");
+	 opack::step_n(world, 100);
+	 opack::stop_trace(world);
+	 for (const auto& record : opack::action_trace("actions.trace").records())
+		 // ...
+	 *@endcode
+	 */
+	void trace_actions(World& world, const std::filesystem::path& path);
+
+	/** Write remaining records of current trace and close it. Nothing happens if actions are not traced. */
+	void stop_trace(World& world);
+}
@@ -0,0 +1,116 @@
+/*****************************************************************//**
+ * @file   bounded_queue.hpp
+ * @brief First in, first out queue with a fixed capacity, stored
+ * in a single circular buffer allocated once.
+ *
+ * @author Tristan
+ * @date   November 2022
+ *********************************************************************/
+#pragma once
+
+#include <cassert>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief First in, first out queue with a fixed capacity, stored in a single circular buffer allocated once.
+ *
+ * Unlike @ref ring_buffer, which always holds @c size() values and overwrites the oldest one,
+ * values are popped from the front and pushing to a full queue fails.
+ *
+ * @tparam T Must be default constructible.
+ *
+ * Usage :
+ * @code{.cpp}
+ bounded_queue<int> q (2); // An empty queue, with room for 2 elements.
+ q.push(1);                // true
+ q.push(2);                // true
+ q.push(3);                // false, queue is full.
+ q.front();                // 1
+ q.pop();
+ q.front();                // 2
+ * @endcode
+ **/
+template<typename T>
+requires std::is_default_constructible_v<T>
+class bounded_queue
+{
+public:
+    explicit bounded_queue(std::size_t capacity = 1) : m_container(capacity)
+    {
+        assert(capacity > 0);
+    }
+
+    [[nodiscard]] std::size_t capacity() const { return m_container.size(); }
+
+    [[nodiscard]] std::size_t size() const { return m_size; }
+
+    [[nodiscard]] bool empty() const { return m_size == 0; }
+
+    [[nodiscard]] bool full() const { return m_size == capacity(); }
+
+    /** Add @c value at the back. Returns false, leaving queue unchanged, if it is full. */
+    bool push(T value)
+    {
+        if (full())
+            return false;
+        m_container[index(m_size)] = std::move(value);
+        ++m_size;
+        return true;
+    }
+
+    /** Oldest value. Assert if empty. */
+    [[nodiscard]] T& front()
+    {
+        assert(!empty());
+        return m_container[m_head];
+    }
+
+    /** Oldest value. Assert if empty. */
+    [[nodiscard]] const T& front() const
+    {
+        assert(!empty());
+        return m_container[m_head];
+    }
+
+    /** Remove oldest value. Assert if empty. */
+    void pop()
+    {
+        assert(!empty());
+        m_container[m_head] = T{};
+        m_head = index(1);
+        --m_size;
+    }
+
+    void clear()
+    {
+        while (!empty())
+            pop();
+    }
+
+    /** @c n th value from the front, @c 0 being the oldest. Assert if @c n is superior or equal to @c size(). */
+    [[nodiscard]] T& operator[](const std::size_t n)
+    {
+        assert(n < m_size);
+        return m_container[index(n)];
+    }
+
+    /** @c n th value from the front, @c 0 being the oldest. Assert if @c n is superior or equal to @c size(). */
+    [[nodiscard]] const T& operator[](const std::size_t n) const
+    {
+        assert(n < m_size);
+        return m_container[index(n)];
+    }
+
+private:
+    [[nodiscard]] std::size_t index(const std::size_t n) const
+    {
+        const auto i = m_head + n;
+        return i < capacity() ? i : i - capacity();
+    }
+
+    std::vector<T> m_container;
+    std::size_t m_head{ 0 };
+    std::size_t m_size{ 0 };
+};
@@ -0,0 +1,108 @@
+/*****************************************************************//**
+ * @file   bump_arena.hpp
+ * @brief Allocator handing out memory by moving a pointer forward, and
+ * freeing everything at once.
+ *
+ * @author Tristan
+ * @date   November 2022
+ *********************************************************************/
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Allocator handing out memory by moving a pointer forward, and freeing everything at once.
+ *
+ * Memory comes from blocks of @c block_size bytes, bigger ones being allocated for bigger values.
+ * @ref reset keeps blocks for next allocations, so that a steady state allocates nothing.
+ * Destructors are never called, hence only trivially destructible values can be created.
+ *
+ * Usage :
+ * @code{.cpp}
+ bump_arena arena;                    // No block allocated yet.
+ auto* value = arena.create<int>(1);  // A block is allocated.
+ arena.reset();                       // value is dangling, block is kept.
+ * @endcode
+ **/
+class bump_arena
+{
+public:
+    explicit bump_arena(const std::size_t block_size = 1 << 16) : m_block_size(block_size)
+    {
+        assert(block_size > 0);
+    }
+
+    /** Construct a @c T from @c args in the arena. Valid until @ref reset. */
+    template<typename T, typename... Args>
+    requires std::is_trivially_destructible_v<T>
+    T* create(Args&&... args)
+    {
+        return new (allocate(sizeof(T), alignof(T))) T{ std::forward<Args>(args)... };
+    }
+
+    /** @c size bytes aligned on @c alignment, which must be a power of two. Valid until @ref reset. */
+    void* allocate(const std::size_t size, const std::size_t alignment = alignof(std::max_align_t))
+    {
+        assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+        while (m_current < m_blocks.size())
+        {
+            auto& block = m_blocks[m_current];
+            const auto address = reinterpret_cast<std::uintptr_t>(block.data.get());
+            const auto aligned = (address + m_offset + alignment - 1) & ~(alignment - 1);
+            if (aligned + size <= address + block.size)
+            {
+                m_offset = aligned + size - address;
+                m_used += size;
+                return reinterpret_cast<void*>(aligned);
+            }
+            ++m_current;
+            m_offset = 0;
+        }
+        // Every kept block is full : add one, big enough for this value even if misaligned.
+        const auto block_size = size + alignment > m_block_size ? size + alignment : m_block_size;
+        m_blocks.push_back({ std::make_unique<std::byte[]>(block_size), block_size });
+        m_current = m_blocks.size() - 1;
+        m_offset = 0;
+        return allocate(size, alignment);
+    }
+
+    /** Free everything allocated, keeping blocks for later. */
+    void reset()
+    {
+        m_current = 0;
+        m_offset = 0;
+        m_used = 0;
+    }
+
+    /** Bytes handed out since last @ref reset, without alignment padding. */
+    [[nodiscard]] std::size_t used() const { return m_used; }
+
+    /** Bytes held by blocks. */
+    [[nodiscard]] std::size_t capacity() const
+    {
+        std::size_t capacity{ 0 };
+        for (const auto& block : m_blocks)
+            capacity += block.size;
+        return capacity;
+    }
+
+private:
+    struct block
+    {
+        std::unique_ptr<std::byte[]> data;
+        std::size_t size;
+    };
+
+    std::size_t m_block_size;
+    std::vector<block> m_blocks;
+    std::size_t m_current{ 0 };
+    std::size_t m_offset{ 0 };
+    std::size_t m_used{ 0 };
+};
@@ -0,0 +1,90 @@
+/*****************************************************************//**
+ * @file   chunked_vector.hpp
+ * @brief Append-only sequence stored in fixed-size chunks, so that
+ * growing never moves nor copies values already stored.
+ *
+ * @author Tristan
+ * @date   November 2022
+ *********************************************************************/
+#pragma once
+
+#include <cassert>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Append-only sequence stored in fixed-size chunks, so that growing never moves nor copies values already stored.
+ *
+ * Unlike @c std::vector, appending costs the same whatever the size, and references to values stay valid.
+ * Values are contiguous within a chunk, so they can be visited, or written out, one chunk at a time.
+ *
+ * @tparam T Must be default constructible.
+ * @tparam ChunkSize Number of values per chunk.
+ *
+ * Usage :
+ * @code{.cpp}
+ chunked_vector<int> v;  // Empty, no chunk allocated.
+ v.push_back(1);         // First chunk is allocated.
+ v.push_back(2);
+ v[1];                   // 2
+ v.for_each_chunk([](std::span<const int> values){}); // Called once with {1, 2}.
+ * @endcode
+ **/
+template<typename T, std::size_t ChunkSize = 1024>
+requires std::is_default_constructible_v<T>
+class chunked_vector
+{
+public:
+    static_assert(ChunkSize > 0, "Chunks must hold at least one value.");
+
+    [[nodiscard]] std::size_t size() const { return m_size; }
+
+    [[nodiscard]] bool empty() const { return m_size == 0; }
+
+    /** Add @c value at the back, allocating a new chunk if last one is full. */
+    void push_back(T value)
+    {
+        if (m_size == m_chunks.size() * ChunkSize)
+            m_chunks.push_back(std::make_unique<T[]>(ChunkSize));
+        m_chunks[m_size / ChunkSize][m_size % ChunkSize] = std::move(value);
+        ++m_size;
+    }
+
+    /** @c n th value, @c 0 being the first pushed. Assert if @c n is superior or equal to @c size(). */
+    [[nodiscard]] T& operator[](const std::size_t n)
+    {
+        assert(n < m_size);
+        return m_chunks[n / ChunkSize][n % ChunkSize];
+    }
+
+    /** @c n th value, @c 0 being the first pushed. Assert if @c n is superior or equal to @c size(). */
+    [[nodiscard]] const T& operator[](const std::size_t n) const
+    {
+        assert(n < m_size);
+        return m_chunks[n / ChunkSize][n % ChunkSize];
+    }
+
+    /** Call @c func with each chunk, in order, as a span of its used values. */
+    template<typename F>
+    void for_each_chunk(F&& func) const
+    {
+        for (std::size_t i = 0; i * ChunkSize < m_size; ++i)
+        {
+            const auto count = m_size - i * ChunkSize < ChunkSize ? m_size - i * ChunkSize : ChunkSize;
+            func(std::span<const T>(m_chunks[i].get(), count));
+        }
+    }
+
+    /** Remove every value and release chunks. */
+    void clear()
+    {
+        m_chunks.clear();
+        m_size = 0;
+    }
+
+private:
+    std::vector<std::unique_ptr<T[]>> m_chunks;
+    std::size_t m_size{ 0 };
+};
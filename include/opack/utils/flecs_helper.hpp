@@ -60,6 +60,17 @@ namespace opack::internal
     }
 
 
+    /**
+     * Returns singleton @c T for in-place modification, or @c nullptr if it does not exist.
+     * Unlike @c world.get_mut<T>(), no copy is queued when world is deferred (e.g. inside systems and observers).
+     * Must not be called concurrently for the same singleton.
+     */
+    template<typename T>
+    T* singleton(const flecs::world& world)
+    {
+        return const_cast<T*>(world.get<T>());
+    }
+
     /**
      * Returns the number of children for entity @c e.
      */
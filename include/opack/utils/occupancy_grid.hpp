@@ -0,0 +1,126 @@
+/*****************************************************************//**
+ * @file   occupancy_grid.hpp
+ * @brief Bounded 2D grid of opaque and transparent cells, with line of sight
+ * checks (<a href="http://www.cse.yorku.ca/~amana/research/grid.pdf">Amanatides and Woo</a>).
+ *
+ * @author Tristan
+ * @date   November 2022
+ *********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+/**
+ * @brief Bounded 2D grid of opaque and transparent cells, with line of sight checks.
+ *
+ * Cells are stored row by row, one byte each, so that a ray only reads contiguous memory
+ * when travelling along a row. Cells outside of the grid are transparent.
+ *
+ * Usage :
+ * @code{.cpp}
+ occupancy_grid grid (10, 10);      // A 10x10 grid with cells of 1 unit.
+ grid.set(5, 5, true);              // Cell (5, 5) is now opaque.
+ grid.visible(4.5f, 5.5f, 6.5f, 5.5f); // false, (5, 5) is in the way.
+ grid.visible(4.5f, 4.5f, 6.5f, 4.5f); // true.
+ * @endcode
+ **/
+class occupancy_grid
+{
+public:
+    explicit occupancy_grid(const std::size_t width = 0, const std::size_t height = 0, const float cell_size = 1.0f)
+        : m_width(width), m_height(height), m_cell_size(cell_size), m_inverse_cell_size(1.0f / cell_size), m_cells(width * height, 0)
+    {
+        assert(cell_size > 0.0f);
+    }
+
+    /** Number of columns. */
+    [[nodiscard]] std::size_t width() const { return m_width; }
+
+    /** Number of rows. */
+    [[nodiscard]] std::size_t height() const { return m_height; }
+
+    /** Length of a cell side. */
+    [[nodiscard]] float cell_size() const { return m_cell_size; }
+
+    /** True if cell (@c x, @c y) blocks line of sight, false otherwise or if it is outside of the grid. */
+    [[nodiscard]] bool opaque(const std::int32_t x, const std::int32_t y) const
+    {
+        if (x < 0 || y < 0 || static_cast<std::size_t>(x) >= m_width || static_cast<std::size_t>(y) >= m_height)
+            return false;
+        return m_cells[static_cast<std::size_t>(y) * m_width + static_cast<std::size_t>(x)] != 0;
+    }
+
+    /** Set whether cell (@c x, @c y) blocks line of sight. */
+    void set(const std::size_t x, const std::size_t y, const bool opaque)
+    {
+        assert(x < m_width && y < m_height);
+        m_cells[y * m_width + x] = opaque ? 1 : 0;
+    }
+
+    /** Make every cell transparent. */
+    void clear()
+    {
+        std::fill(m_cells.begin(), m_cells.end(), std::uint8_t{ 0 });
+    }
+
+    /** Cell containing coordinate @c v. */
+    [[nodiscard]] std::int32_t cell_of(const float v) const
+    {
+        return static_cast<std::int32_t>(std::floor(v * m_inverse_cell_size));
+    }
+
+    /**
+     * True if no opaque cell lies strictly between the cells of (@c x0, @c y0) and (@c x1, @c y1).
+     * Both ends are excluded, so that an entity inside an opaque cell can still see, and be seen.
+     * Each crossed cell is visited once, without any square root or division in the loop.
+     */
+    [[nodiscard]] bool visible(const float x0, const float y0, const float x1, const float y1) const
+    {
+        auto cx = cell_of(x0);
+        auto cy = cell_of(y0);
+        const auto tx = cell_of(x1);
+        const auto ty = cell_of(y1);
+
+        constexpr auto infinity = std::numeric_limits<float>::infinity();
+        const float dx = x1 - x0;
+        const float dy = y1 - y0;
+        const std::int32_t step_x = dx > 0.0f ? 1 : -1;
+        const std::int32_t step_y = dy > 0.0f ? 1 : -1;
+        const float delta_x = dx != 0.0f ? m_cell_size / std::abs(dx) : infinity;
+        const float delta_y = dy != 0.0f ? m_cell_size / std::abs(dy) : infinity;
+        // Ray parameter, in [0, 1], at which next vertical (resp. horizontal) cell boundary is crossed.
+        float next_x = dx != 0.0f ? ((static_cast<float>(cx + (step_x > 0 ? 1 : 0)) * m_cell_size) - x0) / dx : infinity;
+        float next_y = dy != 0.0f ? ((static_cast<float>(cy + (step_y > 0 ? 1 : 0)) * m_cell_size) - y0) / dy : infinity;
+
+        // Exactly one step per crossed boundary, so the loop always ends on the target cell.
+        for (auto steps = std::abs(tx - cx) + std::abs(ty - cy); steps > 1; --steps)
+        {
+            if (cy == ty || (cx != tx && next_x < next_y))
+            {
+                cx += step_x;
+                next_x += delta_x;
+            }
+            else
+            {
+                cy += step_y;
+                next_y += delta_y;
+            }
+            if (opaque(cx, cy))
+                return false;
+        }
+        return true;
+    }
+
+private:
+    std::size_t m_width;
+    std::size_t m_height;
+    float m_cell_size;
+    float m_inverse_cell_size;
+    std::vector<std::uint8_t> m_cells;
+};
@@ -0,0 +1,215 @@
+/*****************************************************************//**
+ * @file   spatial_grid.hpp
+ * @brief Uniform grid indexing values by their 2D position, so that
+ * neighbourhood queries only visit nearby cells (<a href="https://en.wikipedia.org/wiki/Grid_(spatial_index)">Wikipedia</a>).
+ *
+ * @author Tristan
+ * @date   November 2022
+ *********************************************************************/
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include <unordered_map>
+
+/**
+ * @brief Uniform grid indexing values by their 2D position, so that
+ * neighbourhood queries only visit nearby cells.
+ *
+ * Only non-empty cells are stored, so the grid is unbounded. Moving a value
+ * inside its cell only updates its coordinates, buckets are touched only
+ * when the value changes cell.
+ *
+ * @tparam T Must be hashable and equality comparable.
+ *
+ * Usage :
+ * @code{.cpp}
+ spatial_grid<int> grid (10.0f);   // A grid with cells of 10 units.
+ grid.update(1, 0.0f, 0.0f);       // Index value 1 at (0, 0).
+ grid.update(2, 50.0f, 0.0f);      // Index value 2 at (50, 0).
+ grid.query(0.0f, 0.0f, 5.0f, [](int v){});  // Called with 1 only.
+ grid.erase(1);
+ * @endcode
+ **/
+template<typename T>
+class spatial_grid
+{
+public:
+    using key_t = std::int64_t;
+
+    struct entry
+    {
+        T value;
+        float x;
+        float y;
+    };
+
+    explicit spatial_grid(float cell_size = 1.0f) : m_cell_size(cell_size), m_inverse_cell_size(1.0f / cell_size)
+    {
+        assert(cell_size > 0.0f);
+    }
+
+    /** Length of a cell side. */
+    [[nodiscard]] float cell_size() const { return m_cell_size; }
+
+    /** Number of indexed values. */
+    [[nodiscard]] std::size_t size() const { return m_locations.size(); }
+
+    /** True if @c value is indexed, false otherwise. */
+    [[nodiscard]] bool contains(const T& value) const { return m_locations.contains(value); }
+
+    /** Index @c value at (@c x, @c y), or move it there if it is already indexed. */
+    void update(const T& value, const float x, const float y)
+    {
+        const key_t key = key_of(x, y);
+        auto it = m_locations.find(value);
+        if (it == m_locations.end())
+        {
+            attach(m_locations[value], key, { value, x, y });
+            return;
+        }
+
+        auto& location = it->second;
+        if (location.key == key)
+        {
+            auto& e = m_cells.find(key)->second[location.index];
+            e.x = x;
+            e.y = y;
+            return;
+        }
+        detach(location);
+        attach(location, key, { value, x, y });
+    }
+
+    /** Remove @c value from the grid, if indexed. */
+    void erase(const T& value)
+    {
+        const auto it = m_locations.find(value);
+        if (it == m_locations.end())
+            return;
+        detach(it->second);
+        m_locations.erase(it);
+    }
+
+    /**
+     * Call @c func(value) for each value at a distance inferior or equal to @c radius from (@c x, @c y).
+     * If @c func is callable as @c func(value, x, y), coordinates of the value are also passed.
+     * Only cells overlapping the query are visited.
+     */
+    template<typename F>
+    void query(const float x, const float y, const float radius, F&& func) const
+    {
+        const float squared_radius = radius * radius;
+        const auto visit = [&](const std::vector<entry>& bucket)
+        {
+            for (const auto& e : bucket)
+            {
+                const float dx = e.x - x;
+                const float dy = e.y - y;
+                if (dx * dx + dy * dy > squared_radius)
+                    continue;
+                if constexpr (std::is_invocable_v<F, const T&, float, float>)
+                    func(e.value, e.x, e.y);
+                else
+                    func(e.value);
+            }
+        };
+
+        const auto min_x = cell_of(x - radius);
+        const auto max_x = cell_of(x + radius);
+        const auto min_y = cell_of(y - radius);
+        const auto max_y = cell_of(y + radius);
+
+        // Large query compared to how sparse the grid is : cheaper to visit each non-empty cell.
+        if (static_cast<std::size_t>(max_x - min_x + 1) * static_cast<std::size_t>(max_y - min_y + 1) > m_cells.size())
+        {
+            for (const auto& [key, bucket] : m_cells)
+                visit(bucket);
+            return;
+        }
+
+        for (auto cx = min_x; cx <= max_x; ++cx)
+        {
+            for (auto cy = min_y; cy <= max_y; ++cy)
+            {
+                if (const auto it = m_cells.find(pack(cx, cy)); it != m_cells.end())
+                    visit(it->second);
+            }
+        }
+    }
+
+    /** Change cell size and reindex all values. */
+    void rebuild(const float cell_size)
+    {
+        assert(cell_size > 0.0f);
+        std::vector<entry> entries;
+        entries.reserve(size());
+        for (const auto& [key, bucket] : m_cells)
+            entries.insert(entries.end(), bucket.begin(), bucket.end());
+
+        clear();
+        m_cell_size = cell_size;
+        m_inverse_cell_size = 1.0f / cell_size;
+        for (const auto& e : entries)
+            update(e.value, e.x, e.y);
+    }
+
+    /** Remove all values. */
+    void clear()
+    {
+        m_cells.clear();
+        m_locations.clear();
+    }
+
+private:
+    struct location
+    {
+        key_t key;
+        std::size_t index;
+    };
+
+    [[nodiscard]] std::int32_t cell_of(const float v) const
+    {
+        return static_cast<std::int32_t>(std::floor(v * m_inverse_cell_size));
+    }
+
+    [[nodiscard]] static key_t pack(const std::int32_t cx, const std::int32_t cy)
+    {
+        return static_cast<key_t>(static_cast<std::uint64_t>(static_cast<std::uint32_t>(cx)) << 32 | static_cast<std::uint32_t>(cy));
+    }
+
+    [[nodiscard]] key_t key_of(const float x, const float y) const
+    {
+        return pack(cell_of(x), cell_of(y));
+    }
+
+    void attach(location& location, const key_t key, entry e)
+    {
+        auto& bucket = m_cells[key];
+        location = { key, bucket.size() };
+        bucket.push_back(std::move(e));
+    }
+
+    // Swap and pop, so only the moved value location needs to be fixed.
+    void detach(const location& location)
+    {
+        const auto it = m_cells.find(location.key);
+        auto& bucket = it->second;
+        if (location.index != bucket.size() - 1)
+        {
+            bucket[location.index] = std::move(bucket.back());
+            m_locations.find(bucket[location.index].value)->second.index = location.index;
+        }
+        bucket.pop_back();
+        if (bucket.empty())
+            m_cells.erase(it);
+    }
+
+    float m_cell_size;
+    float m_inverse_cell_size;
+    std::unordered_map<key_t, std::vector<entry>> m_cells;
+    std::unordered_map<T, location> m_locations;
+};
@@ -0,0 +1,200 @@
+/*****************************************************************//**
+ * @file   timer_wheel.hpp
+ * @brief Hierarchical timer wheel, to schedule values on integer deadlines
+ * and only touch those expiring (<a href="http://www.cs.columbia.edu/~nahum/w6998/papers/sosp87-timing-wheels.pdf">Varghese and Lauck</a>).
+ *
+ * @author Tristan
+ * @date   November 2022
+ *********************************************************************/
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Hierarchical timer wheel, to schedule values on integer deadlines (ticks).
+ *
+ * Each level has 64 slots, level @c k slots spanning @c 64^k ticks. Entries are placed at the level
+ * where their deadline differs from current tick, and cascaded down to a lower level once current tick
+ * reaches their slot. Deadlines beyond the last level wait in an overflow list, reconsidered each time
+ * the last level wraps. Advancing skips empty slots of the first level, so cost is proportional to expiring
+ * entries and to the number of 64 ticks windows crossed, not to the number of scheduled entries.
+ *
+ * Entries cannot be cancelled : owners should check, when an entry expires, that it is still relevant.
+ *
+ * Usage :
+ * @code{.cpp}
+ timer_wheel<int> wheel;                // Current tick is 0.
+ wheel.schedule(1, 10);                 // 1 expires at tick 10.
+ wheel.schedule(2, 1000);               // 2 expires at tick 1000.
+ wheel.advance(10, [](int value){});    // Called with 1.
+ wheel.advance(2000, [](int value){});  // Called with 2.
+ * @endcode
+ **/
+template<typename T, std::size_t Levels = 4>
+class timer_wheel
+{
+public:
+    static constexpr std::size_t slot_bits = 6;
+    static constexpr std::size_t slot_count = std::size_t{ 1 } << slot_bits;
+    static constexpr std::uint64_t slot_mask = slot_count - 1;
+
+    static_assert(Levels > 0 && Levels * slot_bits < 64, "Levels must fit in a 64 bits tick.");
+
+    explicit timer_wheel(const std::uint64_t now = 0) : m_now(now) {}
+
+    /** Current tick. */
+    [[nodiscard]] std::uint64_t now() const { return m_now; }
+
+    /** Number of scheduled entries, not yet expired. */
+    [[nodiscard]] std::size_t size() const { return m_size; }
+
+    [[nodiscard]] bool empty() const { return m_size == 0; }
+
+    /** Schedule @c value to expire at tick @c deadline. If @c deadline is already reached, it will expire on next @ref advance. */
+    void schedule(T value, const std::uint64_t deadline)
+    {
+        ++m_size;
+        place(entry{ std::move(value), deadline });
+    }
+
+    /**
+     * Move current tick to @c to, calling @c on_expired with each value whose deadline is reached, tick by tick.
+     * Values scheduled by @c on_expired with a deadline already reached will expire on next call.
+     */
+    template<typename F>
+    void advance(const std::uint64_t to, F&& on_expired)
+    {
+        expire(m_due, on_expired);
+        while (m_now < to)
+        {
+            m_now = next_stop(to);
+            cascade();
+            const auto slot = m_now & slot_mask;
+            if (m_occupied[0] & (std::uint64_t{ 1 } << slot))
+            {
+                m_occupied[0] &= ~(std::uint64_t{ 1 } << slot);
+                expire(m_slots[0][slot], on_expired);
+            }
+        }
+    }
+
+    /** Remove every entry, without changing current tick. */
+    void clear()
+    {
+        for (auto& level : m_slots)
+            for (auto& slot : level)
+                slot.clear();
+        m_occupied.fill(0);
+        m_overflow.clear();
+        m_due.clear();
+        m_size = 0;
+    }
+
+private:
+    struct entry
+    {
+        T value;
+        std::uint64_t deadline;
+    };
+
+    using bucket = std::vector<entry>;
+
+    void place(entry&& e)
+    {
+        if (e.deadline <= m_now)
+        {
+            m_due.push_back(std::move(e));
+            return;
+        }
+        // Highest level where deadline and current tick differ.
+        const auto level = static_cast<std::size_t>(std::bit_width(e.deadline ^ m_now) - 1) / slot_bits;
+        if (level >= Levels)
+        {
+            m_overflow.push_back(std::move(e));
+            return;
+        }
+        const auto slot = (e.deadline >> (level * slot_bits)) & slot_mask;
+        m_slots[level][slot].push_back(std::move(e));
+        m_occupied[level] |= std::uint64_t{ 1 } << slot;
+    }
+
+    /** Next tick, up to @c to, where an entry expires or where higher levels must be cascaded. */
+    [[nodiscard]] std::uint64_t next_stop(const std::uint64_t to) const
+    {
+        const auto position = m_now & slot_mask;
+        const auto ahead = position == slot_mask ? 0 : m_occupied[0] & (~std::uint64_t{ 0 } << (position + 1));
+        const auto stop = ahead ? (m_now & ~slot_mask) + static_cast<std::uint64_t>(std::countr_zero(ahead))
+                                : ((m_now >> slot_bits) + 1) << slot_bits;
+        return stop < to ? stop : to;
+    }
+
+    /** Re-place entries of slots that current tick just entered, from highest level to lowest. */
+    void cascade()
+    {
+        if (m_now & slot_mask)
+            return;
+        std::size_t level{ 1 };
+        while (level < Levels && ((m_now >> (level * slot_bits)) & slot_mask) == 0)
+            ++level;
+        if (level == Levels)
+        {
+            std::swap(m_scratch, m_overflow);
+            replace_scratch();
+        }
+        for (auto k = level < Levels ? level : Levels - 1; k > 0; --k)
+        {
+            const auto slot = (m_now >> (k * slot_bits)) & slot_mask;
+            if (!(m_occupied[k] & (std::uint64_t{ 1 } << slot)))
+                continue;
+            m_occupied[k] &= ~(std::uint64_t{ 1 } << slot);
+            std::swap(m_scratch, m_slots[k][slot]);
+            replace_scratch();
+        }
+    }
+
+    /** Re-place cascaded entries. Those expiring on current tick go to current slot, which is expired right after. */
+    void replace_scratch()
+    {
+        for (auto& e : m_scratch)
+        {
+            if (e.deadline == m_now)
+            {
+                m_slots[0][m_now & slot_mask].push_back(std::move(e));
+                m_occupied[0] |= std::uint64_t{ 1 } << (m_now & slot_mask);
+            }
+            else
+                place(std::move(e));
+        }
+        m_scratch.clear();
+    }
+
+    template<typename F>
+    void expire(bucket& expired, F& on_expired)
+    {
+        if (expired.empty())
+            return;
+        bucket current;
+        std::swap(current, expired);
+        m_size -= current.size();
+        for (auto& e : current)
+            on_expired(std::move(e.value));
+        // Keep allocated memory for later, unless callbacks already refilled it.
+        if (expired.empty())
+        {
+            current.clear();
+            std::swap(current, expired);
+        }
+    }
+
+    std::uint64_t m_now;
+    std::size_t m_size{ 0 };
+    std::array<std::array<bucket, slot_count>, Levels> m_slots{};
+    std::array<std::uint64_t, Levels> m_occupied{};
+    bucket m_overflow;
+    bucket m_due;
+    bucket m_scratch;
+};
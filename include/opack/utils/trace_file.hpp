@@ -0,0 +1,201 @@
+/*****************************************************************//**
+ * @file   trace_file.hpp
+ * @brief Binary files of fixed-size records : written from a background
+ * thread with double buffering, and read back through a memory mapping.
+ *
+ * @author Tristan
+ * @date   November 2022
+ *********************************************************************/
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/** Header of a trace file, followed by records. */
+struct trace_header
+{
+    static constexpr std::array<char, 8> expected_magic{ 'O', 'P', 'A', 'C', 'K', 'T', 'R', 'C' };
+    static constexpr std::uint32_t current_version = 1;
+
+    std::array<char, 8> magic{ expected_magic };
+    std::uint32_t version{ current_version };
+    /** Size of a record, to detect a file written with another record type. */
+    std::uint32_t record_size{ 0 };
+};
+static_assert(sizeof(trace_header) == 16, "Records must stay aligned after the header.");
+
+/**
+ * @brief Append records of type @c T to a binary file, from a background thread.
+ *
+ * Records are pushed to a front buffer. Once it holds @c capacity records, it is handed to the writer thread
+ * if this one is idle, and a second buffer is filled meanwhile. If the writer thread is still busy, the front
+ * buffer keeps growing instead, so that @ref push never waits for I/O.
+ * Remaining records are written by @ref close, or on destruction.
+ *
+ * @tparam T Must be trivially copyable, records are written as is.
+ *
+ * Usage :
+ * @code{.cpp}
+ trace_writer<Record> writer ("trace.bin"); // Header is written.
+ writer.push({...});                         // Never blocks on I/O.
+ writer.close();                             // Everything is on disk.
+ * @endcode
+ **/
+template<typename T>
+requires std::is_trivially_copyable_v<T>
+class trace_writer
+{
+public:
+    explicit trace_writer(const std::filesystem::path& path, const std::size_t capacity = 1 << 14)
+        : m_file(path, std::ios::binary | std::ios::trunc), m_capacity(capacity)
+    {
+        if (!m_file)
+            throw std::runtime_error("Cannot open trace file " + path.string());
+        const trace_header header{ .record_size = sizeof(T) };
+        m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        m_front.reserve(m_capacity);
+        m_back.reserve(m_capacity);
+        m_thread = std::thread([this] { run(); });
+    }
+
+    trace_writer(const trace_writer&) = delete;
+    trace_writer& operator=(const trace_writer&) = delete;
+
+    ~trace_writer() { close(); }
+
+    /** Append @c record. Written later, from the writer thread. */
+    void push(const T& record)
+    {
+        m_front.push_back(record);
+        if (m_front.size() >= m_capacity)
+            hand_over();
+    }
+
+    /** Wait for every pushed record to be written, then stop the writer thread. Nothing can be pushed afterwards. */
+    void close()
+    {
+        if (!m_thread.joinable())
+            return;
+        {
+            std::unique_lock lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_back.empty(); });
+            std::swap(m_front, m_back);
+            m_stop = true;
+        }
+        m_condition.notify_all();
+        m_thread.join();
+        m_file.flush();
+    }
+
+private:
+    /** Give front buffer to the writer thread, unless it is still writing the other one. */
+    void hand_over()
+    {
+        std::unique_lock lock(m_mutex, std::try_to_lock);
+        if (!lock || !m_back.empty())
+            return;
+        std::swap(m_front, m_back);
+        lock.unlock();
+        m_condition.notify_all();
+    }
+
+    void run()
+    {
+        std::unique_lock lock(m_mutex);
+        while (true)
+        {
+            m_condition.wait(lock, [this] { return !m_back.empty() || m_stop; });
+            if (m_back.empty())
+                return;
+            // Back buffer is not touched by producer while not empty.
+            lock.unlock();
+            m_file.write(reinterpret_cast<const char*>(m_back.data()), static_cast<std::streamsize>(m_back.size() * sizeof(T)));
+            lock.lock();
+            m_back.clear();
+            m_condition.notify_all();
+        }
+    }
+
+    std::ofstream m_file;
+    std::size_t m_capacity;
+    std::vector<T> m_front;
+    std::vector<T> m_back;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stop{ false };
+    std::thread m_thread;
+};
+
+/**
+ * @brief Read-only memory mapping of a whole file. Platform code lives in the translation unit,
+ * so that system headers are not included by users.
+ **/
+class mapped_file
+{
+public:
+    /** Map @c path. Throws @c std::runtime_error if it cannot be opened or mapped. */
+    explicit mapped_file(const std::filesystem::path& path);
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    ~mapped_file();
+
+    /** First byte of the file, @c nullptr if it is empty. */
+    [[nodiscard]] const char* data() const;
+    [[nodiscard]] std::size_t size() const;
+
+private:
+    struct handle;
+    std::unique_ptr<handle> m_handle;
+};
+
+/**
+ * @brief Read-only view over records of a file written by @ref trace_writer, mapped in memory.
+ *
+ * Records are not copied : pages are loaded by the system when accessed.
+ *
+ * Usage :
+ * @code{.cpp}
+ trace_reader<Record> reader ("trace.bin");
+ for (const auto& record : reader.records()) {}
+ * @endcode
+ **/
+template<typename T>
+requires std::is_trivially_copyable_v<T>
+class trace_reader
+{
+public:
+    explicit trace_reader(const std::filesystem::path& path) : m_file(path)
+    {
+        if (m_file.size() < sizeof(trace_header))
+            throw std::runtime_error("Trace file is too small " + path.string());
+        trace_header header;
+        std::memcpy(&header, m_file.data(), sizeof(header));
+        if (header.magic != trace_header::expected_magic || header.version != trace_header::current_version || header.record_size != sizeof(T))
+            throw std::runtime_error("Invalid trace file " + path.string());
+    }
+
+    /** Records, in the order they were pushed. A partially written last record is ignored. */
+    [[nodiscard]] std::span<const T> records() const
+    {
+        return { reinterpret_cast<const T*>(m_file.data() + sizeof(trace_header)), (m_file.size() - sizeof(trace_header)) / sizeof(T) };
+    }
+
+    [[nodiscard]] std::size_t size() const { return records().size(); }
+
+    [[nodiscard]] const T& operator[](const std::size_t n) const { return records()[n]; }
+
+private:
+    mapped_file m_file;
+};
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cmath>
+
 #include <opack/core.hpp>
 
 opack::World opack::create_world()
@@ -12,6 +15,71 @@ namespace opack
 	void define_action_systems(World& world);
 }
 
+namespace
+{
+	std::uint64_t to_tick(const float time)
+	{
+		return time > 0.0f ? static_cast<std::uint64_t>(std::llround(time / opack::Timers::resolution)) : 0;
+	}
+
+	/** Schedule @c component of @c entity to expire at @c deadline, replacing any previous deadline. */
+	void schedule(opack::EntityView entity, timer_wheel<opack::Timers::Entry>& wheel, const flecs::entity_t component, const std::uint64_t deadline)
+	{
+		auto timers = opack::internal::singleton<opack::Timers>(entity.world());
+		timers->deadlines[{ entity.id(), component }] = deadline;
+		wheel.schedule({ entity.id(), component, deadline }, deadline);
+	}
+
+	/** Remove expired component, or destroy its entity for timeouts, unless it has been removed or set again since. */
+	void expire(flecs::world& world, opack::Timers& timers, const opack::Timers::Entry& entry)
+	{
+		const auto deadline = timers.deadlines.find({ entry.entity, entry.component });
+		if (deadline == timers.deadlines.end() || deadline->second != entry.deadline)
+			return;
+		timers.deadlines.erase(deadline);
+		if (!world.is_alive(entry.entity))
+			return;
+		auto entity = world.entity(entry.entity);
+		if (!entity.owns(entry.component))
+			return;
+		if (entry.component == world.id<opack::TickTimeout>() || entry.component == world.id<opack::TimeTimeout>())
+			entity.destruct();
+		else
+			entity.remove(entry.component);
+	}
+
+	/** True if @c prefab is @c base or inherits from it. */
+	bool inherits(const flecs::entity prefab, const flecs::entity_t base)
+	{
+		if (prefab.id() == base)
+			return true;
+		for (int i = 0; const auto parent = prefab.target(flecs::IsA, i); ++i)
+			if (inherits(parent, base))
+				return true;
+		return false;
+	}
+
+	/** Call @c event callbacks of actions in @c it, resolving them once per action prefab. */
+	void dispatch(flecs::iter& it, const opack::ActionCallbacks::Event event)
+	{
+		auto callbacks = opack::internal::singleton<opack::ActionCallbacks>(it.world());
+		if (callbacks->registered[event].empty() || it.count() == 0)
+			return;
+		// Prefab is part of the table type, so it is shared by all actions of a table.
+		const auto prefab = it.entity(0).target(flecs::IsA);
+		auto [resolved, inserted] = callbacks->resolved[event].try_emplace(prefab.id());
+		if (inserted)
+		{
+			for (const auto& callback : callbacks->registered[event])
+				if (inherits(prefab, callback.prefab))
+					resolved->second.push_back(callback);
+		}
+		for (const auto& callback : resolved->second)
+			for (const auto i : it)
+				callback.invoke(callback.functor, it.entity(i), it.delta_time());
+	}
+}
+
 void opack::import_opack(World& world)
 {
 	world.import<flecs::units>();
@@ -92,6 +160,25 @@ void opack::import_opack(World& world)
 		;
 
 	world.component<RequiredActuator>();
+	world.component<PreemptionPolicy>();
+	world.component<Priority>()
+		.member<std::int32_t>("value")
+		;
+	world.component<ActionQueue>();
+	world.component<Pooled>();
+	world.component<ActionPool>();
+	world.emplace<ActionPool>();
+	world.component<ActionIntents>();
+	world.component<JointActions>();
+	world.emplace<JointActions>();
+	world.component<ActionCallbacks>();
+	world.emplace<ActionCallbacks>();
+	world.component<TrackedActions>()
+		.member<std::size_t>("size")
+		;
+	world.component<ActionHistory>();
+	world.emplace<ActionHistory>();
+	world.emplace<ActionIntents>();
 
 	world.component<By>();
 	world.component<On>();
@@ -110,6 +197,7 @@ void opack::import_opack(World& world)
 	// Knowledge
 	// ----------
 	world.component<Knowledge>();
+	world.component<PerceptMemory>();
 
 	// Misc
 	// ----
@@ -117,6 +205,9 @@ void opack::import_opack(World& world)
 		.member<float, flecs::units::duration::Seconds>("value");
 	world.component<Timer>()
 		.member<float, flecs::units::duration::Seconds>("value");
+	world.component<TickTimeout>();
+	world.component<TimeTimeout>();
+	world.component<Timers>();
 
 	// Phases
 	// --------
@@ -135,48 +226,141 @@ void opack::import_opack(World& world)
 	world.component<Begin>();
 	world.component<End>();
 
+	impl::import_perception(world);
 	impl::import_communication(world);
 	define_action_systems(world);
 
 
-	world.system<Delay>("UpdateDelay")
-		.term<Delay>().write()
-		.each([](flecs::entity entity, Delay& delay)
+	world.emplace<Timers>();
+
+	world.observer<const Delay>("Observer_ScheduleDelay")
+		.event(flecs::OnSet)
+		.term_at(1).self()
+		.each([](flecs::entity entity, const Delay& delay)
+			{
+				schedule(entity, internal::singleton<Timers>(entity.world())->time, entity.world().id<Delay>(), to_tick(entity.world().time() + delay.value));
+			}
+	).child_of<opack::world::dynamics>();
+
+	world.observer<const Timer>("Observer_ScheduleTimer")
+		.event(flecs::OnSet)
+		.term_at(1).self()
+		.each([](flecs::entity entity, const Timer& timer)
 			{
-				delay.value -= entity.delta_time();
-				if (delay.value <= 0)
-					entity.remove<Delay>();
+				schedule(entity, internal::singleton<Timers>(entity.world())->time, entity.world().id<Timer>(), to_tick(entity.world().time() + timer.value));
 			}
 	).child_of<opack::world::dynamics>();
 
-	world.system<Timer>("UpdateTimer")
-		.each([](flecs::entity entity, Timer& timer)
+	world.observer<const TimeTimeout>("Observer_ScheduleTimeTimeout")
+		.event(flecs::OnSet)
+		.term_at(1).self()
+		.each([](flecs::entity entity, const TimeTimeout& timeout)
 			{
-				timer.value -= entity.delta_time();
+				schedule(entity, internal::singleton<Timers>(entity.world())->time, entity.world().id<TimeTimeout>(), to_tick(entity.world().time() + timeout.value));
 			}
 	).child_of<opack::world::dynamics>();
 
-	world.system<TickTimeout>("UpdateTickTimeout")
-		.each([](flecs::entity entity, TickTimeout& timeout)
+	world.observer<const TickTimeout>("Observer_ScheduleTickTimeout")
+		.event(flecs::OnSet)
+		.term_at(1).self()
+		.each([](flecs::entity entity, const TickTimeout& timeout)
 			{
-				timeout.value--;
-				if (timeout.value <= 0)
-					entity.destruct();
+				auto& cycles = internal::singleton<Timers>(entity.world())->cycles;
+				schedule(entity, cycles, entity.world().id<TickTimeout>(), cycles.now() + timeout.value);
 			}
 	).child_of<opack::world::dynamics>();
 
-	world.system<TimeTimeout>("UpdateTimeTimeout")
-		.each([](flecs::entity entity, TimeTimeout& timeout)
+	world.system("System_UpdateTimers")
+		.term<Delay>().write()
+		.term<Timer>().write()
+		.iter([](flecs::iter& it)
 			{
-				timeout.value -= entity.delta_time();
-				if (timeout.value <= 0)
-					entity.destruct();
+				auto world = it.world();
+				auto timers = internal::singleton<Timers>(world);
+				const auto on_expired = [&world, timers](const Timers::Entry& entry) { expire(world, *timers, entry); };
+				timers->time.advance(to_tick(world.time()), on_expired);
+				timers->cycles.advance(timers->cycles.now() + 1, on_expired);
 			}
 	).child_of<opack::world::dynamics>();
 }
 
 void opack::define_action_systems(opack::World& world)
 {
+	world.system("System_PrepareActionIntents")
+		.kind<Cycle::Begin>()
+		.iter([](flecs::iter& it)
+			{
+				internal::singleton<ActionIntents>(it.world())->stages.resize(static_cast<std::size_t>(it.world().get_stage_count()));
+			}
+	).child_of<opack::world::dynamics>();
+
+	world.system("System_EnactActionIntents")
+		.kind<Act::PreUpdate>()
+		.term(ActionStatus::starting).write()
+		.term<Doing>(flecs::Wildcard).write()
+		.iter([](flecs::iter& it)
+			{
+				auto world = it.world();
+				auto& stages = internal::singleton<ActionIntents>(world)->stages;
+				thread_local std::vector<ActionIntents::Intent> intents;
+				intents.clear();
+				for (auto& stage : stages)
+				{
+					intents.insert(intents.end(), stage.begin(), stage.end());
+					stage.clear();
+				}
+				std::sort(intents.begin(), intents.end());
+				intents.erase(std::unique(intents.begin(), intents.end()), intents.end());
+
+				for (const auto& intent : intents)
+				{
+					if (!world.is_alive(intent.initiator) || !world.is_alive(intent.action))
+						continue;
+					auto action = opack::act(world.entity(intent.initiator), world.entity(intent.action));
+					if (intent.target)
+						action.add<On>(intent.target);
+				}
+			}
+	).child_of<opack::world::dynamics>();
+
+	world.system<ActionQueue>("System_StartQueuedActions")
+		.kind<Act::PreUpdate>()
+		.term(flecs::IsA).second<Actuator>()
+		.term(ActionStatus::starting).write()
+		.each([](flecs::entity actuator, ActionQueue& queue)
+			{
+				if (queue.actions.empty())
+					return;
+				if (const auto current = actuator.target<Doing>(); current && internal::is_active(current))
+					return;
+				auto world = actuator.world();
+				while (!queue.actions.empty())
+				{
+					const auto [id, initiator] = queue.actions.front();
+					if (!world.is_alive(id))
+					{
+						queue.actions.pop();
+						continue;
+					}
+					auto action = world.entity(id);
+					// Spawned during this cycle by a system : wait for it to be merged.
+					if (!action.has<RequiredActuator>())
+						return;
+					queue.actions.pop();
+					// Cancelled while waiting.
+					if (!internal::is_active(action))
+						continue;
+					if (!world.is_alive(initiator))
+					{
+						opack::cancel(action);
+						continue;
+					}
+					opack::act(world.entity(initiator), action);
+					return;
+				}
+			}
+	).child_of<opack::world::dynamics>();
+
 	world.system("System_Begin_Actions")
 		.kind<Act::Update>()
 		.term(flecs::IsA).second<opack::Action>()
@@ -186,19 +370,23 @@ void opack::define_action_systems(opack::World& world)
 		.each([](flecs::entity action)
 			{
 				action.add(ActionStatus::running);
+				// Duration counts from the beginning of this cycle.
+				if (const auto duration = action.get<Duration>(); duration && action.owns<Duration>())
+				{
+					auto world = action.world();
+					schedule(action, internal::singleton<Timers>(world)->actions, world.id<Duration>(), to_tick(world.time() - world.delta_time() + duration->value));
+				}
 			}
 	).child_of<opack::world::dynamics>();
 
-	world.system<Duration>("System_Update_ActionDuration")
+	world.system("System_Update_ActionDuration")
 		.kind<Act::Update>()
-		.term<Duration>().self().read_write()
-		.term(flecs::IsA).second<opack::Action>()
-		.term(ActionStatus::running)
-		.each([](flecs::entity entity, Duration& duration)
+		.term<Duration>().write()
+		.iter([](flecs::iter& it)
 			{
-				duration.value -= entity.delta_time();
-				if (duration.value <= 0.0f)
-					entity.remove<Duration>();
+				auto world = it.world();
+				auto timers = internal::singleton<Timers>(world);
+				timers->actions.advance(to_tick(world.time()), [&world, timers](const Timers::Entry& entry) { expire(world, *timers, entry); });
 			}
 	).child_of<opack::world::dynamics>();
 
@@ -217,15 +405,37 @@ void opack::define_action_systems(opack::World& world)
 			}
 	).child_of<opack::world::dynamics>();
 
-	world.system<LastActionPrefabs>("System_RememberLastActionsPrefabs")
+	world.system<const RequiredActuator>("System_RecordActionHistory")
 		.kind<Act::PostUpdate>()
-		.term(flecs::IsA).second<Actuator>()
-		.term<Doing>(flecs::Wildcard)
-		.term<Token>()
-		.each([](flecs::entity actuator, LastActionPrefabs& last_actions)
+		.term(flecs::IsA).second<opack::Action>()
+		.term<By>(flecs::Wildcard)
+		.term(ActionStatus::finished)
+		.term<Token>().self()
+		.each([](flecs::entity action, const RequiredActuator& required)
+			{
+				auto world = action.world();
+				auto history = internal::singleton<ActionHistory>(world);
+				const auto prefab = action.target(flecs::IsA);
+				const auto begin = action.get<Begin, Timestamp>();
+				const auto end = action.get<End, Timestamp>();
+				const auto duration = begin && end ? end->value - begin->value : 0.0f;
+				for (int i = 0; const auto initiator = action.target<By>(i); ++i)
+				{
+					const auto actuator = initiator.target(required.value);
+					if (!actuator)
+						continue;
+					if (const auto tracked = actuator.get<TrackedActions>())
+						history->record(static_cast<std::uint64_t>(world.tick()), initiator.id(), actuator.id(), prefab.id(), duration, tracked->size);
+				}
+			}
+	).child_of<world::dynamics>();
+
+	world.observer<const TrackedActions>("Observer_ForgetActuatorHistory")
+		.event(flecs::OnRemove)
+		.term_at(1).self()
+		.each([](flecs::entity actuator, const TrackedActions&)
 			{
-				if (const auto prefab = actuator.target<Doing>().target(flecs::IsA))
-					last_actions.previous_prefabs_done.push(prefab);
+				internal::singleton<ActionHistory>(actuator.world())->recent.erase(actuator.id());
 			}
 	).child_of<world::dynamics>();
 
@@ -242,17 +452,52 @@ void opack::define_action_systems(opack::World& world)
 	world.system("System_CleanAction")
 		.kind<Cycle::End>()
 		.term<DoNotClean>().optional()
+		.term<Pooled>().optional()
 		.term(flecs::IsA).second<opack::Action>()
 		.term<By>(flecs::Wildcard)
 		.term(ActionStatus::finished).or_()
 		.term(ActionStatus::aborted).or_()
 		.each([](flecs::iter& it, size_t index)
 			{
-				if (auto action = it.entity(index); it.is_set(1))
+				auto action = it.entity(index);
+				internal::singleton<JointActions>(it.world())->joined.erase(action.id());
+				if (it.is_set(1))
 					action.remove<Token>();
+				else if (it.is_set(2))
+					internal::release_action(action);
 				else
 					action.destruct();
 			}
 	).child_of<opack::world::dynamics>();
 
+	// Lifecycle callbacks, one dispatcher per event whatever the number of action types.
+	world.system("System_OnActionBegin")
+		.kind<Act::PreUpdate>()
+		.term(flecs::IsA).second<opack::Action>()
+		.term(ActionStatus::starting)
+		.iter([](flecs::iter& it) { dispatch(it, ActionCallbacks::begin); })
+		.child_of<opack::world::dynamics>();
+
+	world.system("System_OnActionUpdate")
+		.kind<Act::Update>()
+		.term(flecs::IsA).second<opack::Action>()
+		.term(ActionStatus::running)
+		.iter([](flecs::iter& it) { dispatch(it, ActionCallbacks::update); })
+		.child_of<opack::world::dynamics>();
+
+	world.system("System_OnActionCancel")
+		.kind<Act::PostUpdate>()
+		.term(flecs::IsA).second<opack::Action>()
+		.term(ActionStatus::aborted)
+		.term<Token>().self()
+		.iter([](flecs::iter& it) { dispatch(it, ActionCallbacks::cancel); })
+		.child_of<opack::world::dynamics>();
+
+	world.system("System_OnActionEnd")
+		.kind<Act::PostUpdate>()
+		.term(flecs::IsA).second<opack::Action>()
+		.term(ActionStatus::finished)
+		.term<Token>().self()
+		.iter([](flecs::iter& it) { dispatch(it, ActionCallbacks::end); })
+		.child_of<opack::world::dynamics>();
 }
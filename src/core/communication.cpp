@@ -1,4 +1,103 @@
 #include <opack/core/communication.hpp>
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+	/** Deliver messages addressed from systems to mailboxes and channels, then fit buffers and arenas to current stage count. */
+	void deliver(flecs::iter& it)
+	{
+		auto world = it.world();
+		auto& stages = opack::internal::singleton<opack::MailDeliveries>(world)->stages;
+		for (auto& stage : stages)
+		{
+			for (const auto& [receiver, message] : stage)
+			{
+				if (!world.is_alive(receiver) || !world.is_alive(message))
+					continue;
+				// Modified in place : get_mut would queue a copy, as world is deferred.
+				const auto entity = world.entity(receiver);
+				if (const auto log = const_cast<opack::ChannelLog*>(entity.get<opack::ChannelLog>()))
+					log->messages.push_back(message);
+				else if (const auto mailbox = const_cast<opack::Mailbox*>(entity.get<opack::Mailbox>()))
+					mailbox->push(message);
+			}
+			stage.clear();
+		}
+		stages.resize(static_cast<std::size_t>(world.get_stage_count()));
+		// Never shrunk : payloads written by removed stages are still readable.
+		auto arena = opack::internal::singleton<opack::MessageArena>(world);
+		if (arena->stages.size() < stages.size())
+			arena->stages.resize(stages.size());
+	}
+
+	/** Address @c message to @c receiver, directly if possible, or at next cycle if world is deferred. */
+	template<typename F>
+	void address(opack::World world, opack::EntityView receiver, const flecs::entity_t message, F&& push)
+	{
+		if (!world.is_deferred())
+		{
+			push();
+			return;
+		}
+		auto& stages = opack::internal::singleton<opack::MailDeliveries>(world)->stages;
+		const auto stage = static_cast<std::size_t>(world.get_stage_id());
+		opack_assert(stage < stages.size(), "No delivery buffer for stage {}. Was thread count changed during this cycle ?", stage);
+		// Same receiver given twice in a row is delivered once.
+		const opack::MailDeliveries::Delivery delivery{ receiver.id(), message };
+		if (stages[stage].empty() || stages[stage].back() != delivery)
+			stages[stage].push_back(delivery);
+	}
+
+	/** Reuse a consumed message of @c prefab if it is pooled, or create one. */
+	opack::Entity acquire(opack::World world, opack::EntityView prefab)
+	{
+		// Only stage 0 touches the pool, so that threads never share it.
+		if (prefab.has<opack::Pooled>() && world.get_stage_id() == 0)
+		{
+			auto& free = opack::internal::singleton<opack::MessagePool>(world)->free[prefab.id()];
+			while (!free.empty())
+			{
+				const auto id = free.back();
+				free.pop_back();
+				if (world.is_alive(id))
+					return world.entity(id);
+			}
+		}
+		auto message = world.entity().is_a(prefab);
+		opack::internal::organize_entity<opack::Message>(message);
+		return message;
+	}
+
+	/** Destroy @c message, or reset it and give it back to the pool of its prefab if it is pooled. */
+	void discard(opack::Entity message)
+	{
+		if (!message.has<opack::Pooled>())
+		{
+			message.destruct();
+			return;
+		}
+		message
+			.remove<opack::Sender>(flecs::Wildcard)
+			.remove<opack::Receiver>(flecs::Wildcard)
+			.remove<opack::ReaderLeft>(flecs::Wildcard)
+			.remove<opack::Conversation>(flecs::Wildcard)
+			.remove<opack::Performative>(flecs::Wildcard)
+			.remove<opack::Channel>(flecs::Wildcard)
+			.remove<opack::Timestamp>()
+			.remove<opack::TimeTimeout>()
+			.remove<opack::TickTimeout>()
+			.remove<opack::Payload>(flecs::Wildcard);
+		opack::internal::singleton<opack::MessagePool>(message.world())->free[message.target(flecs::IsA).id()].push_back(message.id());
+	}
+
+	opack::ChannelLog& channel_log(opack::EntityView channel)
+	{
+		opack_assert(channel.is_valid(), "Channel is not valid");
+		opack_assert(channel.owns<opack::ChannelLog>(), "{} is not a channel. Was it created with opack::channel<T>(world) ?", channel.path().c_str());
+		return *const_cast<opack::ChannelLog*>(channel.get<opack::ChannelLog>());
+	}
+}
 
 namespace opack
 {
@@ -10,18 +109,78 @@ namespace opack
         world.component<Channel>();
         world.component<Performative>().add(flecs::Exclusive);
 
-        world.entity<Broadcast>().add<Channel>();
+        world.component<ChannelLog>();
+        world.entity<Broadcast>().add<Channel>().set<ChannelLog>({});
 	    world.emplace<queries::Messages>(world);
+        world.component<Mailbox>();
+        world.component<MailDeliveries>();
+        world.emplace<MailDeliveries>();
+        world.component<MessagePool>();
+        world.emplace<MessagePool>();
+        world.component<MessageArena>();
+        world.component<Payload>();
+        world.emplace<MessageArena>();
+
+        world.system<ChannelLog>("System_TrimChannels")
+            .kind<Cycle::End>()
+            .each([](flecs::entity channel, ChannelLog& log)
+                {
+                    auto world = channel.world();
+                    std::erase_if(log.cursors, [&world](const auto& cursor) { return !world.is_alive(cursor.first); });
+                    auto oldest = log.end();
+                    for (const auto& [subscriber, cursor] : log.cursors)
+                        oldest = std::min(oldest, cursor);
+                    // Every subscriber has read these : they leave this channel, and are discarded once nobody else reads them.
+                    for (; log.base < oldest; ++log.base)
+                    {
+                        const auto id = log.messages.front();
+                        log.messages.pop_front();
+                        if (!world.is_alive(id))
+                            continue;
+                        auto message = world.entity(id);
+                        message.remove<Channel>(channel);
+                        if (message.has<DoNotClean>() || message.has<ReaderLeft>(flecs::Wildcard))
+                            continue;
+                        bool published_elsewhere{ false };
+                        for (int i = 0; const auto other = message.target<Channel>(i); ++i)
+                            published_elsewhere |= other != channel;
+                        if (!published_elsewhere)
+                            discard(message);
+                    }
+                }
+        ).child_of<opack::world::dynamics>();
+
+        // Messages written by systems are merged at the end of the cycle, so they are delivered once they exist.
+        world.system("System_DeliverMail")
+            .kind<Cycle::Begin>()
+            .iter([](flecs::iter& it) { deliver(it); })
+            .child_of<opack::world::dynamics>();
 
         world.system("System_CleanMessage")
             .term<const Timestamp>()
             .term(flecs::IsA).second<Message>()
             .term<ReaderLeft>(flecs::Wildcard).not_()
             .term<DoNotClean>().not_()
+            .term<Channel>(flecs::Wildcard).not_()
             .kind<Cycle::End>()
             .each([](Entity message)
                 {
-                    message.destruct();
+                    discard(message);
+                }
+        ).child_of<opack::world::dynamics>();
+
+        // Payloads written during this cycle are kept for the next one, older ones are freed.
+        world.system("System_ResetMessageArena")
+            .kind<Cycle::End>()
+            .iter([](flecs::iter& it)
+                {
+                    auto arena = internal::singleton<MessageArena>(it.world());
+                    for (auto& stage : arena->stages)
+                    {
+                        std::swap(stage.current, stage.previous);
+                        stage.current.reset();
+                    }
+                    ++arena->generation;
                 }
         ).child_of<opack::world::dynamics>();
 	}
@@ -49,6 +208,28 @@ namespace opack
     {
         add<Receiver>(receiver);
         add<ReaderLeft>(receiver);
+        if (receiver.owns<Mailbox>())
+        {
+            address(world(), receiver, id(), [this, receiver]
+                {
+                    auto mailbox = const_cast<Mailbox*>(receiver.get<Mailbox>());
+                    if (mailbox->empty() || mailbox->messages.back() != id())
+                        mailbox->push(id());
+                });
+        }
+        return *this;
+    }
+
+    MessageHandle& MessageHandle::channel(EntityView channel)
+    {
+        opack_assert(channel.is_valid(), "Channel is not valid");
+        add<Channel>(channel);
+        address(world(), channel, id(), [this, channel]
+            {
+                auto& log = channel_log(channel);
+                if (log.messages.empty() || log.messages.back() != id())
+                    log.messages.push_back(id());
+            });
         return *this;
     }
 
@@ -65,10 +246,9 @@ namespace opack
     {	
         opack_assert(sender.is_valid(), "Sender is not valid");
         opack_assert(prefab.is_valid(), "Prefab is not valid");
-		auto message = MessageHandle(sender.world(), sender.world().entity().is_a(prefab));
+		auto message = MessageHandle(sender.world(), acquire(sender.world(), prefab));
 		message.sender(sender);
         message.add<Conversation>(message);
-        opack::internal::organize_entity<Message>(message);
         return message;
 	}
 
@@ -76,10 +256,9 @@ namespace opack
     {
         opack_assert(message.is_valid(), "Message is not valid");
         opack_assert(prefab.is_valid(), "Prefab is not valid");
-		auto reply = MessageHandle(message.world(), message.world().entity().is_a(prefab));
+		auto reply = MessageHandle(message.world(), acquire(message.world(), prefab));
         reply.receiver(message.target<Sender>());
         reply.add<Conversation>(message);
-        opack::internal::organize_entity<Message>(reply);
         return reply;
     }
 
@@ -131,25 +310,69 @@ namespace opack
     {
         opack_assert(agent.is_valid(), "Agent is not valid");
         iter.set_var(query.receiver_var, agent);
+        // Modified in place, even from systems. Only this agent's inbox touches it.
+        if (agent.owns<Mailbox>())
+            mailbox = const_cast<Mailbox*>(agent.get<Mailbox>());
+    }
+
+    void inbox::skip_stale()
+    {
+        auto world = agent.world();
+        while (!mailbox->empty() && (!world.is_alive(mailbox->front()) || !world.entity(mailbox->front()).has<ReaderLeft>(agent)))
+            mailbox->pop();
     }
 
     Entity inbox::first()
     {
+        if (mailbox)
+        {
+            skip_stale();
+            return mailbox->empty() ? Entity{} : agent.world().entity(mailbox->front());
+        }
         return iter.first();
     }
 
     size_t inbox::count()
     {
+        if (mailbox)
+        {
+            skip_stale();
+            auto world = agent.world();
+            return static_cast<size_t>(std::count_if(mailbox->messages.begin() + static_cast<std::ptrdiff_t>(mailbox->head), mailbox->messages.end(),
+                [&world, this](const flecs::entity_t message) { return world.is_alive(message) && world.entity(message).has<ReaderLeft>(agent); }));
+        }
         return static_cast<size_t>(iter.count());
     }
 
     void inbox::clear()
     {
+        if (mailbox)
+        {
+            each([](Entity) {});
+            return;
+        }
         iter.each([this](Entity message) {consume(agent, message); });
     }
 
     void inbox::each(std::function<void(Entity)> func)
     {
+        if (mailbox)
+        {
+            auto world = agent.world();
+            // Only messages delivered so far : those addressed to this agent by func are left for later.
+            for (auto n = mailbox->size(); n > 0; --n)
+            {
+                const auto id = mailbox->front();
+                mailbox->pop();
+                if (!world.is_alive(id) || !world.entity(id).has<ReaderLeft>(agent))
+                    continue;
+                auto message = world.entity(id);
+                consume(agent, message);
+                func(message);
+            }
+            return;
+        }
+
         std::unordered_set<flecs::entity_t> duplicates;
         iter.each(
             [this, &duplicates, &func](flecs::iter& it, size_t index)
@@ -171,10 +394,53 @@ namespace opack
         auto in = inbox(agent);
         auto m = in.first();
         if (m.is_valid())
+        {
+            if (in.mailbox)
+                in.mailbox->pop();
             consume(agent, m);
+        }
         return MessageHandleView(agent.world(), m);
     }
 
+    void subscribe(EntityView subscriber, EntityView channel)
+    {
+        opack_assert(subscriber.is_valid(), "Subscriber is not valid");
+        auto& log = channel_log(channel);
+        log.cursors.try_emplace(subscriber.id(), log.end());
+    }
+
+    void unsubscribe(EntityView subscriber, EntityView channel)
+    {
+        opack_assert(subscriber.is_valid(), "Subscriber is not valid");
+        channel_log(channel).cursors.erase(subscriber.id());
+    }
+
+    MessageHandleView receive(EntityView subscriber, EntityView channel)
+    {
+        opack_assert(subscriber.is_valid(), "Subscriber is not valid");
+        auto& log = channel_log(channel);
+        const auto cursor = log.cursors.find(subscriber.id());
+        opack_assert(cursor != log.cursors.end(), "{} is not subscribed to channel {}.", subscriber.path().c_str(), channel.path().c_str());
+        auto world = subscriber.world();
+        // Messages destroyed meanwhile, e.g. by a timeout, are skipped.
+        while (cursor->second < log.end())
+        {
+            const auto id = log.messages[static_cast<std::size_t>(cursor->second - log.base)];
+            ++cursor->second;
+            if (world.is_alive(id))
+                return MessageHandleView(world, world.entity(id));
+        }
+        return MessageHandleView(world, Entity{});
+    }
+
+    size_t unread(EntityView subscriber, EntityView channel)
+    {
+        opack_assert(subscriber.is_valid(), "Subscriber is not valid");
+        const auto& log = channel_log(channel);
+        const auto cursor = log.cursors.find(subscriber.id());
+        return cursor != log.cursors.end() ? static_cast<size_t>(log.end() - cursor->second) : 0;
+    }
+
     void consume(EntityView reader, Entity message)
     {
         opack_assert(reader.is_valid(), "Reader is not valid");
@@ -1,4 +1,322 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iterator>
+#include <numbers>
+#include <vector>
+
 #include <opack/core/perception.hpp>
+#include <opack/core/components.hpp>
+
+namespace
+{
+	/** True if automatic perception of @c sense instance must be refreshed this tick, according to its @c RefreshRate. */
+	bool should_refresh(flecs::entity sense)
+	{
+		const auto rate = sense.get<opack::RefreshRate>();
+		if (!rate)
+			return true;
+		// Fibonacci hashing of the id, so that consecutive instances get evenly spread offsets in [0, 1).
+		const auto hash = static_cast<std::uint32_t>(static_cast<std::uint32_t>(sense.id()) * 2654435769u);
+		const auto offset = static_cast<float>(hash >> 8) / static_cast<float>(1 << 24);
+		const auto world = sense.world();
+		const auto now = world.time() * rate->value + offset;
+		const auto before = (world.time() - world.delta_time()) * rate->value + offset;
+		return std::floor(now) != std::floor(before);
+	}
+
+	/**
+	 * Stage changes so that @c sense of @c observer perceives exactly subjects in sorted @c located, among subjects with a @c Position.
+	 * Subjects without a position were perceived by other means, so they are left untouched.
+	 * Only reads the world, so it can be called from any worker thread.
+	 */
+	void stage_located_subjects(flecs::entity sense, flecs::entity observer, const std::vector<flecs::entity_t>& located)
+	{
+		using namespace opack;
+		auto& stage = internal::singleton<PerceptionStaging>(sense.world())->stages[static_cast<std::size_t>(sense.world().get_stage_id())];
+
+		internal::each_subject(sense, [&](flecs::entity subject)
+			{
+				if (subject.has<Position>() && !std::binary_search(located.begin(), located.end(), subject.id()))
+					stage.push_back({ observer, sense, subject, false });
+			}
+		);
+		for (const auto subject : located)
+		{
+			if (!sense.has(subject))
+				stage.push_back({ observer, sense, subject, true });
+		}
+	}
+}
+
+void opack::impl::import_perception(World& world)
+{
+	world.component<Position>()
+		.member<float>("x")
+		.member<float>("y")
+		;
+	world.component<Range>()
+		.member<float>("value")
+		;
+	world.component<Heading>()
+		.member<float>("value")
+		;
+	world.component<FieldOfView>()
+		.member<float>("angle")
+		;
+	world.component<Occlusion>();
+	world.component<RefreshRate>()
+		.member<float>("value")
+		;
+	world.component<Percepts>();
+	world.component<Perceivables>();
+	world.component<SenseBit>()
+		.member<std::uint64_t>("value")
+		;
+	world.emplace<SenseRegistry>();
+	world.emplace<SpatialIndex>();
+	world.emplace<PerceptionStaging>();
+
+	world.system("System_PreparePerceptionStaging")
+		.kind<Perceive::PreUpdate>()
+		.iter([](flecs::iter& it)
+			{
+				auto& stages = internal::singleton<PerceptionStaging>(it.world())->stages;
+				stages.resize(static_cast<std::size_t>(it.world().get_stage_count()));
+				for (auto& stage : stages)
+					stage.clear();
+			}
+	).child_of<world::dynamics>();
+
+	world.observer<const Position>("Observer_RemoveFromSpatialIndex")
+		.event(flecs::OnRemove)
+		.each([](flecs::entity entity, const Position&)
+			{
+				if (auto index = internal::singleton<SpatialIndex>(entity.world()))
+					index->grid.erase(entity);
+			}
+	).child_of<world::dynamics>();
+
+	// Only tables whose positions were written since last cycle are visited, so static subjects cost nothing.
+	// Within them, only entities changing cell move between buckets, others just update their coordinates.
+	world.system<const Position>("System_UpdateSpatialIndex")
+		.kind<Perceive::PreUpdate>()
+		.iter([](flecs::iter& it, const Position* position)
+			{
+				if (!it.changed())
+					return;
+				auto index = internal::singleton<SpatialIndex>(it.world());
+				for (auto i : it)
+					index->grid.update(it.entity(i), position[i].x, position[i].y);
+			}
+	).child_of<world::dynamics>();
+
+	world.system<const Range>("System_SpatialPerception")
+		.kind<Perceive::PreUpdate>()
+		.term<const FieldOfView>().not_()
+		.multi_threaded()
+		.each([](flecs::entity sense, const Range& range)
+			{
+				if (!should_refresh(sense))
+					return;
+				const auto observer = sense.parent();
+				const auto position = observer.get<Position>();
+				if (!position)
+					return;
+
+				thread_local std::vector<flecs::entity_t> in_range;
+				in_range.clear();
+				internal::singleton<SpatialIndex>(sense.world())->grid.query(position->x, position->y, range.value,
+					[observer = observer.id()](const flecs::entity_t subject)
+					{
+						if (subject != observer)
+							in_range.push_back(subject);
+					}
+				);
+				std::sort(in_range.begin(), in_range.end());
+				stage_located_subjects(sense, observer, in_range);
+			}
+	).child_of<world::dynamics>();
+
+	// Each candidate in range costs a dot product, then a ray through the occlusion grid.
+	world.system<const Range, const FieldOfView>("System_VisibilityPerception")
+		.kind<Perceive::PreUpdate>()
+		.multi_threaded()
+		.each([](flecs::entity sense, const Range& range, const FieldOfView& field_of_view)
+			{
+				if (!should_refresh(sense))
+					return;
+				const auto observer = sense.parent();
+				const auto position = observer.get<Position>();
+				if (!position)
+					return;
+
+				const auto heading = observer.get<Heading>();
+				const auto angle = heading ? heading->value : 0.0f;
+				const auto direction_x = std::cos(angle);
+				const auto direction_y = std::sin(angle);
+				const auto half_angle_cos = std::cos(field_of_view.angle * 0.5f);
+				const auto omnidirectional = field_of_view.angle >= 2.0f * std::numbers::pi_v<float>;
+				const auto occlusion = sense.world().get<Occlusion>();
+
+				thread_local std::vector<flecs::entity_t> visible;
+				visible.clear();
+				internal::singleton<SpatialIndex>(sense.world())->grid.query(position->x, position->y, range.value,
+					[&, observer = observer.id()](const flecs::entity_t subject, const float x, const float y)
+					{
+						if (subject == observer)
+							return;
+						const auto dx = x - position->x;
+						const auto dy = y - position->y;
+						if (!omnidirectional && dx * direction_x + dy * direction_y < half_angle_cos * std::sqrt(dx * dx + dy * dy))
+							return;
+						if (occlusion && !occlusion->grid.visible(position->x, position->y, x, y))
+							return;
+						visible.push_back(subject);
+					}
+				);
+				std::sort(visible.begin(), visible.end());
+				stage_located_subjects(sense, observer, visible);
+			}
+	).child_of<world::dynamics>();
+
+	// Changes are sorted, so the result doesn't depend on how observers were split between threads.
+	// Declared after automatic perception systems, so that it ends Perceive::PreUpdate and Perceive::Update sees their changes.
+	world.system("System_MergePerceptionStaging")
+		.kind<Perceive::PreUpdate>()
+		.term<Percepts>().write()
+		.iter([](flecs::iter& it)
+			{
+				auto world = it.world();
+				auto& stages = internal::singleton<PerceptionStaging>(world)->stages;
+				thread_local std::vector<PerceptionStaging::Change> changes;
+				changes.clear();
+				for (auto& stage : stages)
+				{
+					changes.insert(changes.end(), stage.begin(), stage.end());
+					stage.clear();
+				}
+				std::sort(changes.begin(), changes.end());
+
+				for (const auto& change : changes)
+				{
+					auto sense = world.entity(change.sense);
+					const auto sense_bit = sense.get<SenseBit>();
+					const auto bit = sense_bit ? sense_bit->value : 0;
+					const auto percepts = internal::percepts(world.entity(change.observer));
+					if (change.perceive)
+					{
+						sense.add(change.subject);
+						if (percepts)
+							percepts->perceive(change.subject, bit);
+					}
+					else
+					{
+						sense.remove(change.subject);
+						if (percepts)
+							internal::conceal(world.entity(change.observer), *percepts, change.subject, bit);
+					}
+				}
+			}
+	).child_of<world::dynamics>();
+
+	// Perceived subjects are stored as pairs (Sense, Instance) on the observer, and as ids on each sense instance,
+	// except for compact senses, only stored in masks.
+	world.system<Percepts>("System_MaterialisePercepts")
+		.kind<Perceive::PostUpdate>()
+		.iter([](flecs::iter& it, Percepts* percepts_column)
+			{
+				auto world = it.world();
+				const auto registry = world.get<SenseRegistry>();
+				for (auto i : it)
+				{
+					const auto observer = it.entity(i);
+					auto& percepts = percepts_column[i];
+					percepts.subjects.clear();
+					percepts.senses.clear();
+					percepts.instances.clear();
+
+					// Compact senses are kept, unless their subject is gone. Others are rebuilt from sense instances.
+					for (auto entry = percepts.masks.begin(); entry != percepts.masks.end();)
+					{
+						if ((entry->second &= registry->compact) == 0 || !world.is_alive(entry->first))
+							entry = percepts.masks.erase(entry);
+						else
+							++entry;
+					}
+
+					observer.each([&percepts, &world](flecs::id id)
+						{
+							if (!id.is_pair() || !opack::is_a<Sense>(id.first()))
+								return;
+							percepts.instances.emplace_back(id.second().id(), ecs_get_table(world.c_ptr(), id.second().id()));
+							const auto begin = static_cast<std::uint32_t>(percepts.subjects.size());
+							const auto sense_bit = id.first().get<SenseBit>();
+							const auto bit = sense_bit ? sense_bit->value : 0;
+							internal::each_subject(id.second(), [&percepts, bit](flecs::entity subject)
+								{
+									percepts.masks[subject] |= bit;
+									if (opack::is_a<Tangible>(subject))
+										percepts.subjects.push_back(subject);
+								}
+							);
+							percepts.senses.push_back({ id.first(), begin, static_cast<std::uint32_t>(percepts.subjects.size()) });
+						}
+					);
+
+					for (auto bits = registry->compact; bits; bits &= bits - 1)
+					{
+						const auto bit = bits & (~bits + 1);
+						const auto begin = static_cast<std::uint32_t>(percepts.subjects.size());
+						for (const auto& [subject, mask] : percepts.masks)
+						{
+							if (mask & bit && opack::is_a<Tangible>(world.entity(subject)))
+								percepts.subjects.push_back(subject);
+						}
+						if (const auto end = static_cast<std::uint32_t>(percepts.subjects.size()); end != begin)
+							percepts.senses.push_back({ registry->senses[std::countr_zero(bits)], begin, end });
+					}
+					percepts.dirty = false;
+
+					// Diff with last materialisation, as sorted sets.
+					thread_local std::vector<flecs::entity_t> known;
+					known.clear();
+					for (const auto& [subject, mask] : percepts.masks)
+						known.push_back(subject);
+					std::sort(known.begin(), known.end());
+					percepts.perceived.clear();
+					percepts.lost.clear();
+					std::set_difference(known.begin(), known.end(), percepts.known.begin(), percepts.known.end(), std::back_inserter(percepts.perceived));
+					std::set_difference(percepts.known.begin(), percepts.known.end(), known.begin(), known.end(), std::back_inserter(percepts.lost));
+					percepts.known.swap(known);
+				}
+			}
+	).child_of<world::dynamics>();
+}
+
+void opack::internal::refresh_perceivables(World& world)
+{
+	auto registry = internal::singleton<SenseRegistry>(world);
+	auto& masks = registry->perceivables;
+	masks.clear();
+	for (std::size_t i = 0; i < registry->senses.size(); ++i)
+	{
+		// Perceivables of bases are inherited, see internal::perceivable.
+		for (auto sense = world.entity(registry->senses[i]); sense; sense = sense.target(flecs::IsA))
+		{
+			if (!sense.owns<Perceivables>())
+				continue;
+			const auto perceivables = sense.get<Perceivables>();
+			if (masks.size() < perceivables->words.size() * 64)
+				masks.resize(perceivables->words.size() * 64, 0);
+			for (std::size_t index = 0; index < perceivables->words.size() * 64; ++index)
+			{
+				if (perceivables->test(index))
+					masks[index] |= std::uint64_t{ 1 } << i;
+			}
+		}
+	}
+}
 
 opack::queries::perception::Entity::Entity(flecs::world& world)
 	: internal::Rule
@@ -1,6 +1,8 @@
 #include <opack/core/simulation.hpp>
 #include <opack/core.hpp>
 
+#include <algorithm>
+
 float opack::target_fps(const World& world) { return world.get_target_fps(); }
 
 void opack::target_fps(World& world, float value) { world.set_target_fps(value); }
@@ -24,6 +26,17 @@ float opack::time(const World& world)
 	return world.time();
 }
 
+float opack::remaining_time(EntityView entity, const flecs::entity_t component)
+{
+	opack_assert(entity.is_valid(), "Entity is invalid.");
+	opack_assert(component != entity.world().id<TickTimeout>(), "Remaining time of a TickTimeout is counted in cycles.");
+	const auto timers = entity.world().get<Timers>();
+	const auto deadline = timers->deadlines.find({ entity.id(), component });
+	if (deadline == timers->deadlines.end() || !entity.owns(component))
+		return 0.0f;
+	return std::max(0.0f, static_cast<float>(deadline->second) * Timers::resolution - entity.world().time());
+}
+
 void opack::run_with_webapp(World& world)
 {
 	fmt::print(fmt::fg(fmt::color::dim_gray) | fmt::emphasis::italic,
@@ -0,0 +1,62 @@
+#include <opack/core/trace.hpp>
+#include <opack/core.hpp>
+
+namespace
+{
+	/** Push a record per initiator of each action of @c it. */
+	void trace(flecs::iter& it)
+	{
+		const auto sink = it.world().get<opack::ActionTraceSink>();
+		if (!sink->writer)
+			return;
+		for (const auto i : it)
+		{
+			const auto action = it.entity(i);
+			const auto status = static_cast<std::uint32_t>(opack::action_status(action));
+			const auto prefab = action.target(flecs::IsA).id();
+			for (int n = 0; const auto initiator = action.target<opack::By>(n); ++n)
+				sink->writer->push({ it.world().time(), status, action.id(), initiator.id(), prefab });
+		}
+	}
+}
+
+void opack::trace_actions(World& world, const std::filesystem::path& path)
+{
+	// Systems are only defined once tracing is asked, so that untraced worlds pay nothing.
+	if (!world.has<ActionTraceSink>())
+	{
+		world.component<ActionTraceSink>();
+		world.emplace<ActionTraceSink>();
+
+		world.system("System_TraceActionBegin")
+			.kind<Act::PreUpdate>()
+			.term(flecs::IsA).second<opack::Action>()
+			.term<By>(flecs::Wildcard)
+			.term(ActionStatus::starting)
+			.iter([](flecs::iter& it) { trace(it); })
+			.child_of<opack::world::dynamics>();
+
+		world.system("System_TraceActionEnd")
+			.kind<Act::PostUpdate>()
+			.term(flecs::IsA).second<opack::Action>()
+			.term<By>(flecs::Wildcard)
+			.term(ActionStatus::finished).or_()
+			.term(ActionStatus::aborted).or_()
+			.term<Token>().self()
+			.iter([](flecs::iter& it) { trace(it); })
+			.child_of<opack::world::dynamics>();
+	}
+	stop_trace(world);
+	world.get_mut<ActionTraceSink>()->writer = std::make_shared<trace_writer<ActionTraceRecord>>(path);
+}
+
+void opack::stop_trace(World& world)
+{
+	if (!world.has<ActionTraceSink>())
+		return;
+	if (const auto sink = world.get_mut<ActionTraceSink>(); sink->writer)
+	{
+		sink->writer->close();
+		sink->writer.reset();
+	}
+}
@@ -0,0 +1,88 @@
+#include <opack/utils/trace_file.hpp>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+struct mapped_file::handle
+{
+    HANDLE file{ INVALID_HANDLE_VALUE };
+    HANDLE mapping{ nullptr };
+    const char* data{ nullptr };
+    std::size_t size{ 0 };
+
+    ~handle()
+    {
+        if (data)
+            UnmapViewOfFile(data);
+        if (mapping)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+    }
+};
+
+mapped_file::mapped_file(const std::filesystem::path& path) : m_handle(std::make_unique<handle>())
+{
+    m_handle->file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_handle->file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Cannot open trace file " + path.string());
+    LARGE_INTEGER size;
+    GetFileSizeEx(m_handle->file, &size);
+    m_handle->size = static_cast<std::size_t>(size.QuadPart);
+    if (m_handle->size == 0)
+        return;
+    m_handle->mapping = CreateFileMappingW(m_handle->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_handle->mapping)
+        throw std::runtime_error("Cannot map trace file " + path.string());
+    m_handle->data = static_cast<const char*>(MapViewOfFile(m_handle->mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_handle->data)
+        throw std::runtime_error("Cannot map trace file " + path.string());
+}
+#else
+struct mapped_file::handle
+{
+    int file{ -1 };
+    const char* data{ nullptr };
+    std::size_t size{ 0 };
+
+    ~handle()
+    {
+        if (data)
+            ::munmap(const_cast<char*>(data), size);
+        if (file >= 0)
+            ::close(file);
+    }
+};
+
+mapped_file::mapped_file(const std::filesystem::path& path) : m_handle(std::make_unique<handle>())
+{
+    m_handle->file = ::open(path.c_str(), O_RDONLY);
+    if (m_handle->file < 0)
+        throw std::runtime_error("Cannot open trace file " + path.string());
+    struct stat status {};
+    ::fstat(m_handle->file, &status);
+    m_handle->size = static_cast<std::size_t>(status.st_size);
+    if (m_handle->size == 0)
+        return;
+    auto data = ::mmap(nullptr, m_handle->size, PROT_READ, MAP_PRIVATE, m_handle->file, 0);
+    if (data == MAP_FAILED)
+        throw std::runtime_error("Cannot map trace file " + path.string());
+    m_handle->data = static_cast<const char*>(data);
+}
+#endif
+
+mapped_file::~mapped_file() = default;
+
+const char* mapped_file::data() const { return m_handle->data; }
+
+std::size_t mapped_file::size() const { return m_handle->size; }
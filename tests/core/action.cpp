@@ -1,5 +1,10 @@
 #include <doctest/doctest.h>
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
 #include <opack/core.hpp>
+#include <opack/core/trace.hpp>
 #include <opack/module/simple_agent.hpp>
 
 TEST_CASE("Action API")
@@ -180,7 +185,478 @@ TEST_CASE("Action API : tracking")
 
     CHECK(opack::has_done<SomeAction>(e1));
     CHECK(opack::last_action_prefab<simple::Actuator>(e1) == action_prefab);
-	CHECK(opack::last_actions<simple::Actuator>(e1).previous_prefabs_done.contains(action_prefab));
+	CHECK(opack::last_actions<simple::Actuator>(e1).count(action_prefab) == 1);
 	CHECK(opack::last_actions<simple::Actuator>(e1).peek(0) == action_prefab);
 	CHECK(opack::last_actions<simple::Actuator>(e1).has_done(action_prefab));
+
+    MESSAGE("Only last actions are indexed, but all are recorded");
+    for (int i = 0; i < 4; ++i)
+    {
+        opack::act<SomeAction>(e1);
+        opack::step(world);
+    }
+    const auto last = opack::last_actions<simple::Actuator>(e1);
+    CHECK(last.size() == static_cast<std::size_t>(buffer_size));
+    CHECK(last.count(action_prefab) == static_cast<std::size_t>(buffer_size));
+    CHECK(!last.peek(static_cast<std::size_t>(buffer_size)));
+
+    const auto& history = opack::action_history(world);
+    CHECK(history.size() == 5);
+    CHECK(history.initiators[4] == e1.id());
+    CHECK(history.actuators[4] == opack::actuator<simple::Actuator>(e1).id());
+    CHECK(history.prefabs[4] == action_prefab.id());
+    CHECK(history.ticks[0] < history.ticks[4]);
+
+    MESSAGE("Drained records are removed, last actions are kept");
+    std::size_t drained{ 0 };
+    opack::drain_action_history(world, [&drained](const opack::ActionHistory& records) { drained = records.size(); });
+    CHECK(drained == 5);
+    CHECK(history.size() == 0);
+    CHECK(opack::last_actions<simple::Actuator>(e1).has_done(action_prefab));
+
+    MESSAGE("Removed actuators are forgotten");
+    const auto actuator = opack::actuator<simple::Actuator>(e1).id();
+    CHECK(history.recent.contains(actuator));
+    e1.destruct();
+    CHECK(!history.recent.contains(actuator));
+}
+
+TEST_CASE("Action API : pooling")
+{
+    OPACK_ACTION(Wave);
+    OPACK_ACTION(Wait);
+
+    auto world = opack::create_world();
+    world.import<simple>();
+    opack::init<Wave>(world).require<simple::Actuator>();
+    opack::init<Wait>(world).require<simple::Actuator>().duration(2.0f);
+    auto e1 = opack::spawn<simple::Agent>(world);
+    auto e2 = opack::spawn<simple::Agent>(world);
+
+    MESSAGE("Finished actions are recycled");
+    auto action = opack::act<Wave>(e1);
+    CHECK(action.has<opack::Pooled>());
+    CHECK(opack::current_action<simple::Actuator>(e1) == action);
+    opack::step(world);
+    CHECK(action.is_valid());
+    CHECK(opack::action_status(action) == opack::ActionStatus::waiting);
+    CHECK(!opack::current_action<simple::Actuator>(e1));
+    CHECK(!opack::initiator(action));
+    CHECK(!opack::has_started(action));
+
+    auto reused = opack::act<Wave>(e2);
+    CHECK(reused == action);
+    CHECK(opack::initiator(reused) == e2);
+    CHECK(opack::current_action<simple::Actuator>(e2) == action);
+
+    MESSAGE("Pools are per prefab");
+    auto other = opack::act<Wait>(e1);
+    CHECK(other != action);
+    CHECK(opack::duration(other) == 2.0f);
+
+    MESSAGE("Duration is restored");
+    opack::step(world, 1.0f);
+    opack::step(world, 1.0f);
+    opack::step(world); // We didn't add a sync point for this use case
+    opack::step(world);
+    CHECK(other.is_valid());
+    CHECK(!opack::current_action<simple::Actuator>(e1));
+    CHECK(opack::act<Wait>(e1) == other);
+    CHECK(opack::duration(other) == 2.0f);
+
+    MESSAGE("Instances spawned by user are not pooled");
+    auto spawned = opack::spawn<Wave>(world);
+    opack::act(e2, spawned);
+    opack::step(world);
+    CHECK(!spawned.is_valid());
+}
+
+TEST_CASE("Action API : bulk")
+{
+    OPACK_ACTION(Wave);
+
+    auto world = opack::create_world();
+    world.import<simple>();
+    auto prefab = opack::init<Wave>(world).require<simple::Actuator>();
+
+    std::vector<opack::Entity> agents;
+    for (int i = 0; i < 10; ++i)
+        agents.push_back(opack::spawn<simple::Agent>(world));
+
+    const auto check = [&]()
+    {
+        std::vector<opack::Entity> actions;
+        for (const auto& agent : agents)
+        {
+            const auto action = opack::current_action<simple::Actuator>(agent);
+            REQUIRE(action.is_valid());
+            CHECK(opack::is_a<Wave>(action));
+            CHECK(opack::initiator(action) == agent);
+            CHECK(opack::action_status(action) == opack::ActionStatus::starting);
+            CHECK(opack::has_started(action));
+            actions.push_back(action);
+        }
+        std::sort(actions.begin(), actions.end());
+        CHECK(std::adjacent_find(actions.begin(), actions.end()) == actions.end());
+        return actions;
+    };
+
+    opack::act_n(agents, prefab);
+    const auto created = check();
+    opack::step(world);
+    CHECK(!opack::current_action<simple::Actuator>(agents.front()));
+
+    MESSAGE("Pooled instances are reused");
+    opack::act_n<Wave>(agents);
+    CHECK(check() == created);
+
+    MESSAGE("Deferred, as in systems");
+    opack::step(world);
+    agents.push_back(opack::spawn<simple::Agent>(world));
+    world.defer_begin();
+    opack::act_n<Wave>(agents);
+    world.defer_end();
+    const auto deferred = check();
+    CHECK(std::includes(deferred.begin(), deferred.end(), created.begin(), created.end()));
+}
+
+TEST_CASE("Action API : intents")
+{
+    OPACK_ACTION(Wave);
+
+    const auto done = [](const std::int32_t threads)
+    {
+        auto world = opack::create_world();
+        world.set_threads(threads);
+        world.import<simple>();
+        opack::init<Wave>(world).require<simple::Actuator>();
+        opack::entity<simple::Actuator>(world).track(1);
+        auto target = opack::spawn<opack::Artefact>(world);
+
+        std::vector<opack::Entity> agents;
+        for (int i = 0; i < 100; ++i)
+            agents.push_back(opack::spawn<simple::Agent>(world));
+
+        std::vector<opack::Entity> targets(agents.size());
+        world.system()
+            .kind<opack::Reason::Update>()
+            .term(flecs::IsA).second<simple::Agent>()
+            .multi_threaded()
+            .each([target](flecs::entity agent)
+                {
+                    opack::intend<Wave>(agent, target);
+                    opack::intend<Wave>(agent, target);
+                });
+        opack::on_action_begin<Wave>(world, [&](opack::Entity action)
+            {
+                const auto index = std::find(agents.begin(), agents.end(), opack::initiator(action)) - agents.begin();
+                targets[static_cast<std::size_t>(index)] = action.target<opack::On>();
+            });
+        opack::step(world);
+        opack::step(world);
+
+        std::size_t count{ 0 };
+        for (std::size_t i = 0; i < agents.size(); ++i)
+        {
+            CHECK(targets[i] == target);
+            count += opack::has_done<Wave>(agents[i]);
+        }
+        return count;
+    };
+
+    CHECK(done(1) == 100);
+    CHECK(done(4) == 100);
+}
+
+TEST_CASE("Action API : preemption")
+{
+    OPACK_ACTION(Walk);
+    OPACK_ACTION(Flee);
+
+    struct Cancelled { std::size_t count{ 0 }; };
+
+    auto world = opack::create_world();
+    world.import<simple>();
+    opack::init<Walk>(world).require<simple::Actuator>().duration(10.0f)
+        .on_action_cancel<Walk>([](flecs::entity action) { opack::initiator(action).get_mut<Cancelled>()->count++; });
+    opack::init<Flee>(world).require<simple::Actuator>().priority(1);
+    auto agent = opack::spawn<simple::Agent>(world).add<Cancelled>();
+
+    const auto cancelled = [&]() { return agent.get<Cancelled>()->count; };
+
+    SUBCASE("Replace")
+    {
+        auto first = opack::act<Walk>(agent);
+        opack::step(world);
+        auto second = opack::act<Walk>(agent);
+        CHECK(opack::action_status(first) == opack::ActionStatus::aborted);
+        CHECK(opack::is_finished(first));
+        CHECK(opack::current_action<simple::Actuator>(agent) == second);
+        opack::step(world);
+        CHECK(cancelled() == 1);
+    }
+
+    SUBCASE("Reject")
+    {
+        simple::get_actuator(world).preemption(opack::Preemption::reject);
+        auto first = opack::act<Walk>(agent);
+        opack::step(world);
+        auto second = opack::act<Walk>(agent);
+        CHECK(opack::action_status(second) == opack::ActionStatus::aborted);
+        CHECK(opack::current_action<simple::Actuator>(agent) == first);
+        opack::step(world);
+        CHECK(cancelled() == 1);
+        CHECK(opack::action_status(first) == opack::ActionStatus::running);
+
+        MESSAGE("Higher priority preempts");
+        auto flee = opack::act<Flee>(agent);
+        CHECK(opack::action_status(first) == opack::ActionStatus::aborted);
+        CHECK(opack::current_action<simple::Actuator>(agent) == flee);
+    }
+
+    SUBCASE("Queue")
+    {
+        simple::get_actuator(world).preemption(opack::Preemption::queue);
+        auto agent2 = opack::spawn<simple::Agent>(world).add<Cancelled>();
+        auto first = opack::act<Flee>(agent2);
+        auto second = opack::act<Walk>(agent2);
+        CHECK(opack::action_status(second) == opack::ActionStatus::waiting);
+        CHECK(opack::current_action<simple::Actuator>(agent2) == first);
+        opack::step(world);
+        CHECK(opack::action_status(second) == opack::ActionStatus::waiting);
+        opack::step(world);
+        CHECK(opack::current_action<simple::Actuator>(agent2) == second);
+        CHECK(opack::action_status(second) == opack::ActionStatus::running);
+    }
+
+    SUBCASE("Plan")
+    {
+        struct Ended { std::size_t count{ 0 }; };
+        opack::on_action_end<Flee>(world, [](flecs::entity action) { opack::initiator(action).get_mut<Ended>()->count++; });
+        simple::get_actuator(world).queue(2);
+        auto planner = opack::spawn<simple::Agent>(world).add<Ended>();
+        const auto ended = [&]() { return planner.get<Ended>()->count; };
+
+        auto a = opack::enqueue<Flee>(planner);
+        auto b = opack::enqueue<Flee>(planner);
+        auto c = opack::enqueue<Flee>(planner);
+        CHECK(opack::action_status(a) == opack::ActionStatus::waiting);
+        CHECK(opack::action_status(b) == opack::ActionStatus::waiting);
+        CHECK(opack::action_status(c) == opack::ActionStatus::aborted);
+        CHECK(!opack::current_action<simple::Actuator>(planner));
+
+        MESSAGE("One action per cycle, without reasoning");
+        opack::step(world);
+        CHECK(ended() == 1);
+        CHECK(opack::action_status(b) == opack::ActionStatus::waiting);
+        opack::step(world);
+        CHECK(ended() == 2);
+        opack::step(world);
+        CHECK(ended() == 2);
+    }
+
+    SUBCASE("Recycled after preemption")
+    {
+        auto first = opack::act<Walk>(agent);
+        opack::step(world, 1.0f);
+        opack::act<Flee>(agent);
+        CHECK(opack::action_status(first) == opack::ActionStatus::aborted);
+        opack::step(world, 1.0f);
+
+        MESSAGE("Original deadline passes while instance is pooled");
+        opack::step_n(world, 10, 1.0f);
+        auto reused = opack::act<Walk>(agent);
+        CHECK(reused == first);
+        opack::step(world, 1.0f);
+        CHECK(opack::is_in_progress(reused));
+        CHECK(opack::duration(reused) == 10.0f);
+        opack::step_n(world, 5, 1.0f);
+        CHECK(opack::is_in_progress(reused));
+    }
+
+    SUBCASE("Cancel")
+    {
+        auto action = opack::act<Walk>(agent);
+        opack::step(world);
+        opack::cancel(action);
+        CHECK(!opack::current_action<simple::Actuator>(agent));
+        opack::step(world);
+        CHECK(cancelled() == 1);
+        CHECK(!opack::current_action<simple::Actuator>(agent));
+    }
+}
+
+TEST_CASE("Action API : joint actions")
+{
+    OPACK_ACTION(Lift);
+    OPACK_ACTION(Chat);
+
+    auto world = opack::create_world();
+    world.import<simple>();
+    opack::init<Lift>(world).require<simple::Actuator>().arity(2, 2).duration(1.0f);
+    opack::init<Chat>(world).require<simple::Actuator>().arity(2, 3);
+    auto e1 = opack::spawn<simple::Agent>(world);
+    auto e2 = opack::spawn<simple::Agent>(world);
+    auto e3 = opack::spawn<simple::Agent>(world);
+
+    MESSAGE("Action waits for enough initiators");
+    auto lift = opack::act<Lift>(e1);
+    CHECK(opack::action_status(lift) == opack::ActionStatus::waiting);
+    CHECK(opack::current_action<simple::Actuator>(e1) == lift);
+    opack::step(world);
+    CHECK(!opack::has_started(lift));
+
+    MESSAGE("Initiators are matched with pending actions");
+    CHECK(opack::act<Lift>(e2) == lift);
+    CHECK(opack::action_status(lift) == opack::ActionStatus::starting);
+    CHECK(opack::initiator(lift, 0) == e1);
+    CHECK(opack::initiator(lift, 1) == e2);
+    auto other = opack::act<Lift>(e3);
+    CHECK(other != lift);
+    CHECK(opack::action_status(other) == opack::ActionStatus::waiting);
+    opack::step(world);
+    CHECK(opack::is_in_progress(lift));
+    CHECK(!opack::has_started(other));
+
+    MESSAGE("Started actions accept initiators up to maximum arity");
+    auto c1 = opack::spawn<simple::Agent>(world);
+    auto c2 = opack::spawn<simple::Agent>(world);
+    auto c3 = opack::spawn<simple::Agent>(world);
+    auto c4 = opack::spawn<simple::Agent>(world);
+    auto chat = opack::act<Chat>(c1);
+    opack::act(c2, chat);
+    CHECK(opack::action_status(chat) == opack::ActionStatus::starting);
+    CHECK(opack::act(c3, chat) == chat);
+    CHECK(opack::initiator(chat, 2) == c3);
+    opack::act(c4, chat);
+    CHECK(!opack::current_action<simple::Actuator>(c4));
+}
+
+TEST_CASE("Action API : joint actions admission")
+{
+    OPACK_ACTION(Lift);
+    OPACK_ACTION(Wave);
+
+    auto world = opack::create_world();
+    world.import<simple>();
+    opack::init<Lift>(world).require<simple::Actuator>().arity(2, 2).duration(1.0f);
+    opack::init<Wave>(world).require<simple::Actuator>().duration(5.0f);
+    auto e1 = opack::spawn<simple::Agent>(world);
+    auto e2 = opack::spawn<simple::Agent>(world);
+    auto e3 = opack::spawn<simple::Agent>(world);
+
+    SUBCASE("Same initiator twice")
+    {
+        auto first = opack::act<Lift>(e1);
+        auto second = opack::act<Lift>(e1);
+        CHECK(second != first);
+        CHECK(opack::action_status(first) == opack::ActionStatus::aborted);
+        CHECK(opack::action_status(second) == opack::ActionStatus::waiting);
+        CHECK(opack::current_action<simple::Actuator>(e1) == second);
+
+        MESSAGE("A partner is still needed");
+        CHECK(opack::act<Lift>(e2) == second);
+        CHECK(opack::action_status(second) == opack::ActionStatus::starting);
+        CHECK(opack::initiator(second, 0) == e1);
+        CHECK(opack::initiator(second, 1) == e2);
+    }
+
+    SUBCASE("Rejected initiator")
+    {
+        simple::get_actuator(world).preemption(opack::Preemption::reject);
+        opack::act<Wave>(e1);
+        auto lift = opack::act<Lift>(e2);
+        auto rejected = opack::act<Lift>(e1);
+        CHECK(rejected != lift);
+        CHECK(opack::action_status(rejected) == opack::ActionStatus::aborted);
+        CHECK(opack::action_status(lift) == opack::ActionStatus::waiting);
+        CHECK(!lift.has<opack::By>(e1));
+
+        MESSAGE("Shared instance is left for others");
+        CHECK(opack::act<Lift>(e3) == lift);
+        CHECK(opack::action_status(lift) == opack::ActionStatus::starting);
+    }
+}
+
+TEST_CASE("Action API : callbacks")
+{
+    OPACK_ACTION(Jump);
+    OPACK_ACTION(Run);
+    struct Calls { std::vector<std::string> names; };
+
+    auto world = opack::create_world();
+    world.import<simple>();
+    world.set<Calls>({});
+    const auto systems = world.count(flecs::System);
+    auto record = [&world](const char* name) { return [&world, name](opack::Entity) { world.get_mut<Calls>()->names.push_back(name); }; };
+    opack::init<Jump>(world).require<simple::Actuator>()
+        .on_action_begin<Jump>(record("jump begin"))
+        .on_action_end<Jump>(record("jump end"));
+    opack::init<Run>(world).require<simple::Actuator>()
+        .on_action_begin<Run>(record("run begin"));
+    opack::on_action_begin<opack::Action>(world, record("action begin"));
+    auto e1 = opack::spawn<simple::Agent>(world);
+    auto e2 = opack::spawn<simple::Agent>(world);
+
+    MESSAGE("Callbacks are called for action type and its bases, in registration order");
+    opack::act<Jump>(e1);
+    opack::step(world);
+    CHECK(world.get<Calls>()->names == std::vector<std::string>{ "jump begin", "action begin", "jump end" });
+
+    MESSAGE("Callbacks registered later are taken into account");
+    world.get_mut<Calls>()->names.clear();
+    opack::on_action_begin<Run>(world, record("run begin again"));
+    opack::act<Run>(e2);
+    opack::step(world);
+    CHECK(world.get<Calls>()->names == std::vector<std::string>{ "run begin", "action begin", "run begin again" });
+
+    MESSAGE("No system is added per callback");
+    CHECK(world.count(flecs::System) == systems);
+}
+
+TEST_CASE("Action API : trace")
+{
+    OPACK_ACTION(Wave);
+    OPACK_ACTION(Walk);
+
+    auto world = opack::create_world();
+    world.import<simple>();
+    opack::init<Wave>(world).require<simple::Actuator>();
+    opack::init<Walk>(world).require<simple::Actuator>().duration(1.0f);
+    auto e1 = opack::spawn<simple::Agent>(world);
+    auto e2 = opack::spawn<simple::Agent>(world);
+
+    MESSAGE("Nothing is traced before asking");
+    opack::act<Wave>(e1);
+    opack::step(world);
+
+    const auto path = std::filesystem::temp_directory_path() / "opack_action_trace_test.bin";
+    opack::trace_actions(world, path);
+    auto wave = opack::act<Wave>(e1);
+    auto walk = opack::act<Walk>(e2);
+    opack::step(world, 1.0f);
+    opack::step(world, 1.0f);
+    opack::step(world);
+    opack::stop_trace(world);
+    opack::act<Wave>(e1);
+    opack::step(world);
+
+    {
+        opack::action_trace trace(path);
+        const auto records = trace.records();
+        REQUIRE(records.size() == 4);
+        const auto count = [&records](opack::EntityView action, opack::EntityView initiator, opack::EntityView prefab, opack::ActionStatus status)
+        {
+            return std::count_if(records.begin(), records.end(), [&](const opack::ActionTraceRecord& record)
+                {
+                    return record.action == action.id() && record.initiator == initiator.id() && record.prefab == prefab.id() && record.status == static_cast<std::uint32_t>(status);
+                });
+        };
+        CHECK(count(wave, e1, opack::entity<Wave>(world), opack::ActionStatus::starting) == 1);
+        CHECK(count(wave, e1, opack::entity<Wave>(world), opack::ActionStatus::finished) == 1);
+        CHECK(count(walk, e2, opack::entity<Walk>(world), opack::ActionStatus::starting) == 1);
+        CHECK(count(walk, e2, opack::entity<Walk>(world), opack::ActionStatus::finished) == 1);
+        CHECK(std::all_of(records.begin(), records.end(), [](const opack::ActionTraceRecord& record) { return record.timestamp >= 1.0f; }));
+    }
+    std::filesystem::remove(path);
 }
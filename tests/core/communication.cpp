@@ -1,4 +1,5 @@
 #include <doctest/doctest.h>
+#include <vector>
 #include <opack/core.hpp>
 #include <opack/module/fipa_acl.hpp>
 
@@ -180,3 +181,230 @@ TEST_CASE("Communication in systems")
 	CHECK(send_counter == expected);
 	CHECK(receive_counter == send_counter);
 }
+
+TEST_CASE("Communication API : mailboxes")
+{
+	OPACK_AGENT(MyAgent);
+    auto world = opack::create_world();
+	opack::init<MyAgent>(world);
+	opack::add_mailbox<MyAgent>(world);
+
+	auto sender		= opack::spawn<MyAgent>(world);
+	auto receiver_1 = opack::spawn<MyAgent>(world);
+	auto receiver_2 = opack::spawn<MyAgent>(world);
+	CHECK(receiver_1.owns<opack::Mailbox>());
+
+	auto message = opack::write(sender)
+		.performative(fipa_acl::Performative::AcceptProposal)
+		.receiver(receiver_1)
+		.receiver(receiver_2)
+		.send();
+	CHECK(receiver_1.get<opack::Mailbox>()->size() == 1);
+	CHECK(opack::inbox(receiver_2).count() == 1);
+	CHECK(opack::inbox(sender).count() == 0);
+
+	auto m = opack::receive(receiver_1);
+	CHECK(m == message);
+	CHECK(opack::has_been_read_by(m, receiver_1));
+	CHECK(!opack::receive(receiver_1).is_valid());
+	opack::step(world);
+	CHECK(message.is_alive()); // Still one receiver left.
+
+	int count{ 0 };
+	opack::inbox(receiver_2).each([&count, &message](opack::Entity m) { CHECK(m == message); ++count; });
+	CHECK(count == 1);
+	CHECK(opack::inbox(receiver_2).count() == 0);
+	opack::step(world);
+	CHECK(!message.is_alive());
+
+	MESSAGE("Messages consumed otherwise are skipped");
+	message = opack::write(sender).receiver(receiver_1).send();
+	opack::consume(receiver_1, message);
+	CHECK(!opack::receive(receiver_1).is_valid());
+
+	MESSAGE("Messages addressed from systems are delivered at next cycle");
+	world.system()
+		.kind<opack::Reason::Update>()
+		.term(flecs::IsA).second<MyAgent>()
+		.each([receiver_1](flecs::entity e)
+			{
+				if (e != receiver_1)
+					opack::write(e).receiver(receiver_1).send();
+			});
+	int received{ 0 };
+	world.system()
+		.kind<opack::Act::Update>()
+		.term(flecs::IsA).second<MyAgent>()
+		.each([&received](flecs::entity e)
+			{
+				opack::inbox(e).each([&received](opack::Entity) { ++received; });
+			});
+	opack::step(world);
+	CHECK(received == 0);
+	opack::step_n(world, 2);
+	CHECK(received == 4);
+}
+
+TEST_CASE("Communication API : channels")
+{
+	OPACK_AGENT(MyAgent);
+	struct News {};
+    auto world = opack::create_world();
+	opack::init<MyAgent>(world);
+	auto news = opack::channel<News>(world);
+
+	auto publisher = opack::spawn<MyAgent>(world);
+	std::vector<opack::Entity> subscribers;
+	for (int i = 0; i < 100; ++i)
+	{
+		subscribers.push_back(opack::spawn<MyAgent>(world));
+		opack::subscribe(subscribers.back(), news);
+	}
+	auto late = opack::spawn<MyAgent>(world);
+
+	auto first = opack::write(publisher)
+		.performative(fipa_acl::Performative::Inform)
+		.channel(news)
+		.send();
+	CHECK(!first.has<opack::ReaderLeft>(flecs::Wildcard));
+	opack::subscribe(late, news);
+	auto second = opack::write(publisher).channel(news).send();
+
+	CHECK(opack::unread(subscribers[0], news) == 2);
+	CHECK(opack::unread(late, news) == 1);
+	CHECK(opack::receive(late, news) == second);
+	CHECK(!opack::receive(late, news).is_valid());
+
+	MESSAGE("Messages are kept until every subscriber read them");
+	for (auto& subscriber : subscribers)
+		CHECK(opack::receive(subscriber, news) == first);
+	opack::step(world);
+	CHECK(!first.is_alive());
+	CHECK(second.is_alive());
+
+	for (std::size_t i = 0; i < subscribers.size() - 1; ++i)
+		CHECK(opack::receive(subscribers[i], news) == second);
+	opack::step(world);
+	CHECK(second.is_alive());
+
+	MESSAGE("Unsubscribed or destroyed subscribers do not hold messages");
+	opack::unsubscribe(subscribers.back(), news);
+	opack::step(world);
+	CHECK(!second.is_alive());
+
+	auto third = opack::write(publisher).channel(news).send();
+	for (std::size_t i = 0; i < subscribers.size() - 1; ++i)
+		opack::receive(subscribers[i], news);
+	late.destruct();
+	opack::step(world);
+	CHECK(!third.is_alive());
+
+	MESSAGE("Messages with receivers are kept until they read them");
+	auto receiver = opack::spawn<MyAgent>(world);
+	auto mixed = opack::write(publisher)
+		.performative(fipa_acl::Performative::Inform)
+		.receiver(receiver)
+		.channel(news)
+		.send();
+	for (std::size_t i = 0; i < subscribers.size() - 1; ++i)
+		opack::receive(subscribers[i], news);
+	opack::step(world);
+	CHECK(mixed.is_alive());
+	CHECK(!mixed.has<opack::Channel>(news));
+	CHECK(opack::receive(receiver) == mixed);
+	opack::step(world);
+	CHECK(!mixed.is_alive());
+
+	MESSAGE("Messages published on several channels are kept until read on each");
+	struct Alerts {};
+	auto alerts = opack::channel<Alerts>(world);
+	auto watcher = opack::spawn<MyAgent>(world);
+	opack::subscribe(watcher, alerts);
+	auto both = opack::write(publisher).channel(news).channel(alerts).send();
+	for (std::size_t i = 0; i < subscribers.size() - 1; ++i)
+		opack::receive(subscribers[i], news);
+	opack::step(world);
+	CHECK(both.is_alive());
+	CHECK(!both.has<opack::Channel>(news));
+	CHECK(both.has<opack::Channel>(alerts));
+	CHECK(opack::receive(watcher, alerts) == both);
+	opack::step(world);
+	CHECK(!both.is_alive());
+
+	MESSAGE("Messages published from systems are delivered at next cycle");
+	auto reader = subscribers.front();
+	world.system()
+		.kind<opack::Reason::Update>()
+		.term(flecs::IsA).second<MyAgent>()
+		.each([&publisher, &news](flecs::entity e)
+			{
+				if (e == publisher)
+					opack::write(e).channel(news).send();
+			});
+	opack::step(world);
+	CHECK(opack::unread(reader, news) == 0);
+	opack::step(world);
+	CHECK(opack::unread(reader, news) == 1);
+}
+
+TEST_CASE("Communication API : pooling")
+{
+	OPACK_AGENT(MyAgent);
+	OPACK_MESSAGE(PooledMessage);
+	struct Content { int value; };
+    auto world = opack::create_world();
+	opack::init<MyAgent>(world);
+	opack::init<PooledMessage>(world);
+	opack::pool_messages<PooledMessage>(world);
+
+	auto sender = opack::spawn<MyAgent>(world);
+	auto receiver = opack::spawn<MyAgent>(world);
+
+	auto message = opack::write<PooledMessage>(sender)
+		.performative(fipa_acl::Performative::Inform)
+		.receiver(receiver)
+		.payload<Content>(42)
+		.send();
+	CHECK(opack::payload<Content>(message)->value == 42);
+	CHECK(opack::receive(receiver) == message);
+	opack::step(world);
+
+	MESSAGE("Consumed messages are reset instead of destroyed");
+	CHECK(message.is_alive());
+	CHECK(!message.has<opack::Sender>(flecs::Wildcard));
+	CHECK(!message.has<opack::Receiver>(flecs::Wildcard));
+	CHECK(!message.has<opack::Performative>(flecs::Wildcard));
+	CHECK(!message.has<opack::Timestamp>());
+	CHECK(!opack::payload<Content>(message));
+
+	MESSAGE("They are reused by next message of the same prefab");
+	CHECK(opack::write(sender) != message);
+	auto next = opack::write<PooledMessage>(sender).receiver(receiver).send();
+	CHECK(next == message);
+	CHECK(!opack::payload<Content>(next));
+	CHECK(opack::sender(next) == sender);
+	CHECK(opack::conversation_id(next) == next);
+	CHECK(opack::has_receiver(next, receiver));
+
+	MESSAGE("Payloads expire at the end of the cycle after they were written");
+	auto expiring = opack::write(sender).payload<Content>(1);
+	opack::step(world);
+	CHECK(opack::payload<Content>(expiring)->value == 1);
+	opack::step(world);
+	CHECK(!opack::payload<Content>(expiring));
+	opack::consume(receiver, next);
+
+	MESSAGE("Payloads written from systems are readable at next cycle");
+	world.system()
+		.kind<opack::Reason::Update>()
+		.term(flecs::IsA).second<MyAgent>()
+		.each([&sender, &receiver](flecs::entity e)
+			{
+				if (e == sender)
+					opack::write<PooledMessage>(e).receiver(receiver).payload<Content>(7).send();
+			});
+	opack::step(world);
+	auto received = opack::receive(receiver);
+	CHECK(received.is_valid());
+	CHECK(opack::payload<Content>(received)->value == 7);
+}
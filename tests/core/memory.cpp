@@ -0,0 +1,64 @@
+#include <doctest/doctest.h>
+#include <opack/core.hpp>
+
+OPACK_SUB_PREFAB(MemoryAgent, opack::Agent);
+OPACK_SUB_PREFAB(MemorySense, opack::Sense);
+
+struct Health { float value{ 1.0f }; };
+struct Secret { int value{ 0 }; };
+
+TEST_CASE("Memory API")
+{
+    auto world = opack::create_world();
+    opack::init<MemoryAgent>(world);
+    opack::init<MemorySense>(world);
+    opack::perceive<MemorySense, Health>(world);
+    opack::add_sense<MemorySense, MemoryAgent>(world);
+    opack::add_memory<MemoryAgent, Health, Secret>(world, 2, 1.0f);
+
+    auto observer = opack::spawn<MemoryAgent>(world);
+    auto e1 = opack::spawn<MemoryAgent>(world).set<Health>({ 0.5f }).set<Secret>({ 1 });
+    auto e2 = opack::spawn<MemoryAgent>(world);
+    auto e3 = opack::spawn<MemoryAgent>(world);
+    auto m = opack::memory(observer);
+
+    opack::perceive<MemorySense>(observer, e1);
+    opack::perceive<MemorySense>(observer, e2);
+    opack::step(world, 0.1f);
+    CHECK(!m.remembers(e1));
+
+    opack::conceal<MemorySense>(observer, e1);
+    e1.set<Health>({ 0.25f });
+    opack::step(world, 0.1f);
+    CHECK(m.remembers(e1));
+    CHECK(m.last_seen(e1) == doctest::Approx(0.2f));
+    // Changes after it was lost are not remembered.
+    REQUIRE(m.value<Health>(e1) != nullptr);
+    CHECK(m.value<Health>(e1)->value == 0.5f);
+    // Not perceivable through MemorySense.
+    CHECK(m.value<Secret>(e1) == nullptr);
+    CHECK(!m.remembers(e2));
+
+    SUBCASE("Decay")
+    {
+        opack::step_n(world, 9, 0.1f);
+        CHECK(m.remembers(e1));
+        opack::step(world, 0.2f);
+        CHECK(!m.remembers(e1));
+        CHECK(m.value<Health>(e1) == nullptr);
+    }
+
+    SUBCASE("Capacity")
+    {
+        opack::conceal<MemorySense>(observer, e2);
+        opack::perceive<MemorySense>(observer, e3);
+        opack::step(world, 0.1f);
+        CHECK(m.remembers(e2));
+        CHECK(m.value<Health>(e2) == nullptr);
+        opack::conceal<MemorySense>(observer, e3);
+        opack::step(world, 0.1f);
+        CHECK(m.remembers(e3));
+        CHECK(m.remembers(e2));
+        CHECK(!m.remembers(e1));
+    }
+}
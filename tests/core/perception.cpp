@@ -1,5 +1,7 @@
 #include <doctest/doctest.h>
 #include <opack/core.hpp>
+#include <algorithm>
+#include <numbers>
 
 OPACK_SUB_PREFAB(MyAgent, opack::Agent);
 OPACK_SUB_PREFAB(MySense, opack::Sense);
@@ -59,4 +61,458 @@ TEST_CASE("Perception API")
             if (subject == e3)
                 CHECK(!p.perceive<MySense, Test>(subject));
         });
-}
\ No newline at end of file
+}
+
+TEST_CASE("Perception API : spatial")
+{
+    auto world = opack::create_world();
+    opack::init<MyAgent>(world);
+    opack::init<MySense>(world).range(2.0f);
+    opack::add_sense<MySense, MyAgent>(world);
+
+    auto observer = opack::spawn<MyAgent>(world).set<opack::Position>({ 0.0f, 0.0f });
+    auto close_subject = opack::spawn<MyAgent>(world).set<opack::Position>({ 1.0f, 1.0f });
+    auto distant_subject = opack::spawn<MyAgent>(world).set<opack::Position>({ 5.0f, 5.0f });
+    auto unlocated_subject = opack::spawn<MyAgent>(world);
+    opack::perceive<MySense>(observer, unlocated_subject);
+
+    opack::step(world);
+    auto p = opack::perception(observer);
+    CHECK(!p.perceive<MySense>(observer));
+    CHECK(p.perceive<MySense>(close_subject));
+    CHECK(!p.perceive<MySense>(distant_subject));
+    CHECK(p.perceive<MySense>(unlocated_subject));
+    CHECK(opack::perception(close_subject).perceive<MySense>(observer));
+
+    distant_subject.set<opack::Position>({ 0.0f, -1.5f });
+    close_subject.set<opack::Position>({ 10.0f, 10.0f });
+    opack::step(world);
+    CHECK(!p.perceive<MySense>(close_subject));
+    CHECK(p.perceive<MySense>(distant_subject));
+    CHECK(p.perceive<MySense>(unlocated_subject));
+
+    SUBCASE("Range override")
+    {
+        opack::sense<MySense>(observer).set<opack::Range>({ 20.0f });
+        opack::step(world);
+        CHECK(p.perceive<MySense>(close_subject));
+        CHECK(p.perceive<MySense>(distant_subject));
+    }
+
+    SUBCASE("Destruction")
+    {
+        distant_subject.destruct();
+        opack::step(world);
+        CHECK(world.get<opack::SpatialIndex>()->grid.size() == 2);
+    }
+
+    SUBCASE("Same cycle")
+    {
+        // Changes staged during Perceive::PreUpdate are merged before Perceive::Update.
+        bool perceived{ false };
+        world.system()
+            .kind<opack::Perceive::Update>()
+            .iter([&](flecs::iter&) { perceived = opack::perception(observer).perceive<MySense>(close_subject); });
+        close_subject.set<opack::Position>({ 1.0f, 0.0f });
+        opack::step(world);
+        CHECK(perceived);
+    }
+}
+
+TEST_CASE("Perception API : cache")
+{
+    auto world = opack::create_world();
+    opack::init<MyAgent>(world);
+    opack::init<MySense>(world);
+    opack::add_sense<MySense, MyAgent>(world);
+    auto e1 = opack::spawn<MyAgent>(world, "e1");
+    auto e2 = opack::spawn<MyAgent>(world, "e2");
+    auto e3 = opack::spawn<MyAgent>(world, "e3");
+    CHECK(e1.has<opack::Percepts>());
+    CHECK(e1.get<opack::Percepts>() != e2.get<opack::Percepts>());
+
+    opack::perceive<MySense>(e1, e2);
+    opack::perceive<MySense>(e1, e3);
+    auto p = opack::perception(e1);
+    CHECK(e1.get<opack::Percepts>()->dirty);
+    CHECK(p.subjects<MySense>().empty());
+
+    opack::step(world);
+    CHECK(!e1.get<opack::Percepts>()->dirty);
+    CHECK(p.subjects<MySense>().size() == 2);
+
+    int count{ 0 };
+    p.each<MyAgent>([&](opack::Entity subject) { CHECK((subject == e2 || subject == e3)); ++count; });
+    CHECK(count == 2);
+
+    // Changes are visible right away, through rules, until next materialisation.
+    opack::conceal<MySense>(e1, e3);
+    CHECK(e1.get<opack::Percepts>()->dirty);
+    count = 0;
+    p.each<MyAgent>([&](opack::Entity subject) { CHECK(subject == e2); ++count; });
+    CHECK(count == 1);
+
+    opack::step(world);
+    CHECK(p.subjects<MySense>().size() == 1);
+    CHECK(p.subjects<MySense>().front() == e2.id());
+
+    MESSAGE("Sense instances edited directly are detected");
+    opack::sense<MySense>(e1).add(e3);
+    opack::sense<MySense>(e1).remove(e2);
+    CHECK(!e1.get<opack::Percepts>()->dirty);
+    CHECK(p.perceive(e3));
+    CHECK(!p.perceive(e2));
+    count = 0;
+    p.each<MyAgent>([&](opack::Entity subject) { CHECK(subject == e3); ++count; });
+    CHECK(count == 1);
+
+    opack::step(world);
+    CHECK(p.subjects<MySense>().size() == 1);
+    CHECK(p.subjects<MySense>().front() == e3.id());
+}
+
+OPACK_SUB_PREFAB(MyOtherSense, opack::Sense);
+
+TEST_CASE("Perception API : any sense")
+{
+    auto world = opack::create_world();
+    opack::init<MyAgent>(world);
+    opack::init<MySense>(world);
+    opack::init<MyOtherSense>(world);
+    opack::add_sense<MySense, MyAgent>(world);
+    opack::add_sense<MyOtherSense, MyAgent>(world);
+    opack::perceive<MyOtherSense, Test, R>(world);
+    CHECK(opack::entity<MySense>(world).get<opack::SenseBit>()->value != opack::entity<MyOtherSense>(world).get<opack::SenseBit>()->value);
+
+    auto e1 = opack::spawn<MyAgent>(world, "e1");
+    auto e2 = opack::spawn<MyAgent>(world, "e2").set<Test>({ 2.0 });
+    auto e3 = opack::spawn<MyAgent>(world, "e3");
+    e2.add<R>(e3);
+    auto p = opack::perception(e1);
+
+    CHECK(!p.perceive(e2));
+    opack::perceive<MySense>(e1, e2);
+    CHECK(p.perceive(e2));
+    CHECK(!p.perceive<opack::Sense, Test>(e2));
+    CHECK(p.value<opack::Sense, Test>(e2) == nullptr);
+
+    opack::perceive<MyOtherSense>(e1, e2);
+    CHECK(p.perceive<opack::Sense, Test>(e2));
+    CHECK(p.value<opack::Sense, Test>(e2)->value == 2.0);
+    CHECK(!p.perceive<opack::Sense, R>(e2, e3));
+    opack::perceive<MySense>(e1, e3);
+    CHECK(!p.perceive<opack::Sense, R>(e2, e3));
+    opack::perceive<MyOtherSense>(e1, e3);
+    CHECK(p.perceive<opack::Sense, R>(e2, e3));
+
+    opack::step(world);
+    CHECK(p.perceive(e2));
+    opack::conceal<MySense, MyOtherSense>(e1, e2);
+    CHECK(!p.perceive(e2));
+    CHECK(p.perceive(e3));
+}
+
+TEST_CASE("Perception API : changes")
+{
+    auto world = opack::create_world();
+    opack::init<MyAgent>(world);
+    opack::init<MySense>(world);
+    opack::init<MyOtherSense>(world);
+    opack::add_sense<MySense, MyAgent>(world);
+    opack::add_sense<MyOtherSense, MyAgent>(world);
+    auto e1 = opack::spawn<MyAgent>(world, "e1");
+    auto e2 = opack::spawn<MyAgent>(world, "e2");
+    auto e3 = opack::spawn<MyAgent>(world, "e3");
+
+    std::vector<opack::Entity> perceived;
+    std::vector<opack::Entity> lost;
+    opack::on_perceived<MyAgent>(world, [&](opack::Entity observer, opack::Entity subject) { if (observer == e1) perceived.push_back(subject); });
+    opack::on_lost<MyAgent>(world, [&](opack::Entity observer, opack::Entity subject) { if (observer == e1) lost.push_back(subject); });
+
+    opack::perceive<MySense>(e1, e2);
+    opack::step(world);
+    CHECK(perceived == std::vector{ e2 });
+    CHECK(lost.empty());
+
+    // Nothing changed, so nothing is reported.
+    perceived.clear();
+    opack::step(world);
+    CHECK(perceived.empty());
+
+    // Still perceived with another sense.
+    opack::perceive<MyOtherSense>(e1, e2);
+    opack::perceive<MySense>(e1, e3);
+    opack::conceal<MySense>(e1, e2);
+    opack::step(world);
+    CHECK(perceived == std::vector{ e3 });
+    CHECK(lost.empty());
+
+    perceived.clear();
+    opack::conceal<MyOtherSense>(e1, e2);
+    e3.destruct();
+    opack::step(world);
+    CHECK(perceived.empty());
+    CHECK(lost.size() == 2);
+}
+
+TEST_CASE("Perception API : bulk")
+{
+    auto world = opack::create_world();
+    opack::init<MyAgent>(world);
+    opack::init<MySense>(world);
+    opack::init<MyOtherSense>(world);
+    opack::add_sense<MySense, MyAgent>(world);
+    opack::add_sense<MyOtherSense, MyAgent>(world);
+    auto e1 = opack::spawn<MyAgent>(world, "e1");
+    auto e2 = opack::spawn<MyAgent>(world, "e2");
+    auto e3 = opack::spawn<MyAgent>(world, "e3");
+    auto p1 = opack::perception(e1);
+    auto p2 = opack::perception(e2);
+
+    const auto subjects = std::vector{ e2, e3 };
+    opack::perceive_all<MySense, MyOtherSense>(e1, subjects);
+    CHECK(p1.perceive<MySense>(e2));
+    CHECK(p1.perceive<MySense>(e3));
+    CHECK(p1.perceive<MyOtherSense>(e3));
+
+    opack::conceal_all<MySense>(e1, subjects);
+    CHECK(!p1.perceive<MySense>(e2));
+    CHECK(!p1.perceive<MySense>(e3));
+    CHECK(p1.perceive(e3));
+
+    const auto pairs = std::vector<std::pair<opack::Entity, opack::Entity>>{ {e1, e2}, {e2, e1}, {e2, e3} };
+    opack::perceive_all<MySense>(world, pairs);
+    CHECK(p1.perceive<MySense>(e2));
+    CHECK(!p1.perceive<MySense>(e3));
+    CHECK(p2.perceive<MySense>(e1));
+    CHECK(p2.perceive<MySense>(e3));
+
+    opack::conceal_all<MySense>(world, pairs);
+    CHECK(!p1.perceive<MySense>(e2));
+    CHECK(!p2.perceive<MySense>(e1));
+    CHECK(!p2.perceive<MySense>(e3));
+}
+
+OPACK_SUB_PREFAB(MyCompactSense, opack::Sense);
+
+TEST_CASE("Perception API : compact storage")
+{
+    auto world = opack::create_world();
+    opack::init<MyAgent>(world);
+    opack::init<MySense>(world);
+    opack::init<MyCompactSense>(world);
+    opack::add_sense<MySense, MyAgent>(world);
+    opack::add_sense<MyCompactSense, MyAgent>(world, opack::SenseStorage::compact);
+    opack::perceive<MyCompactSense, Test>(world);
+
+    auto e1 = opack::spawn<MyAgent>(world, "e1");
+    auto e2 = opack::spawn<MyAgent>(world, "e2").set<Test>({ 2.0 });
+    auto e3 = opack::spawn<MyAgent>(world, "e3");
+    CHECK(e1.has<MySense>(flecs::Wildcard));
+    CHECK(!e1.has<MyCompactSense>(flecs::Wildcard));
+    auto p = opack::perception(e1);
+
+    opack::perceive<MySense, MyCompactSense>(e1, e2);
+    opack::perceive<MyCompactSense>(e1, e3);
+    CHECK(p.perceive<MySense>(e2));
+    CHECK(p.perceive<MyCompactSense>(e2));
+    CHECK(p.perceive<MyCompactSense>(e3));
+    CHECK(!p.perceive<MySense>(e3));
+    CHECK(p.perceive<MyCompactSense, Test>(e2));
+    CHECK(!p.perceive<MySense, Test>(e2));
+    CHECK(p.value<MyCompactSense, Test>(e2)->value == 2.0);
+
+    int count{ 0 };
+    p.each<MyAgent>([&](opack::Entity) { ++count; });
+    CHECK(count == 3);
+
+    opack::step(world);
+    CHECK(p.subjects<MyCompactSense>().size() == 2);
+    CHECK(p.subjects<MySense>().size() == 1);
+    count = 0;
+    p.each<MyAgent>([&](opack::Entity) { ++count; });
+    CHECK(count == 3);
+
+    opack::conceal<MyCompactSense>(e1, e2);
+    CHECK(!p.perceive<MyCompactSense>(e2));
+    CHECK(p.perceive<MySense>(e2));
+
+    e3.destruct();
+    opack::step(world);
+    CHECK(p.subjects<MyCompactSense>().empty());
+    CHECK(!p.perceive(e3));
+}
+
+TEST_CASE("Perception API : field of view")
+{
+    auto world = opack::create_world();
+    opack::init<MyAgent>(world);
+    opack::init<MySense>(world).range(10.0f).field_of_view(std::numbers::pi_v<float> / 2.0f);
+    opack::add_sense<MySense, MyAgent>(world);
+
+    auto observer = opack::spawn<MyAgent>(world).set<opack::Position>({ 0.5f, 0.5f });
+    auto front = opack::spawn<MyAgent>(world).set<opack::Position>({ 5.5f, 0.5f });
+    auto behind = opack::spawn<MyAgent>(world).set<opack::Position>({ -4.5f, 0.5f });
+    auto side = opack::spawn<MyAgent>(world).set<opack::Position>({ 4.5f, 3.5f });
+    auto p = opack::perception(observer);
+
+    opack::step(world);
+    CHECK(p.perceive<MySense>(front));
+    CHECK(!p.perceive<MySense>(behind));
+    CHECK(p.perceive<MySense>(side));
+
+    world.set<opack::Occlusion>({ occupancy_grid(10, 10) });
+    world.get_mut<opack::Occlusion>()->grid.set(3, 0, true);
+    opack::step(world);
+    CHECK(!p.perceive<MySense>(front));
+    CHECK(p.perceive<MySense>(side));
+
+    observer.set<opack::Heading>({ std::numbers::pi_v<float> });
+    opack::step(world);
+    CHECK(!p.perceive<MySense>(front));
+    CHECK(p.perceive<MySense>(behind));
+    CHECK(!p.perceive<MySense>(side));
+}
+
+TEST_CASE("Perception API : refresh rate")
+{
+    auto world = opack::create_world();
+    opack::init<MyAgent>(world);
+    opack::init<MySense>(world).range(2.0f).refresh_rate(1.0f);
+    opack::add_sense<MySense, MyAgent>(world);
+
+    auto subject = opack::spawn<MyAgent>(world).set<opack::Position>({ 0.0f, 0.0f });
+    std::vector<opack::Entity> observers;
+    for (int i = 0; i < 40; i++)
+        observers.push_back(opack::spawn<MyAgent>(world).set<opack::Position>({ 1.0f, 0.0f }));
+    const auto count = [&]()
+    {
+        return std::count_if(observers.begin(), observers.end(), [&](opack::Entity o) { return opack::perception(o).perceive<MySense>(subject); });
+    };
+
+    // A quarter of the period : only some observers have been refreshed.
+    opack::step(world, 0.25f);
+    CHECK(count() > 0);
+    CHECK(count() < 40);
+
+    // A full period : every observer has been refreshed once.
+    opack::step_n(world, 3, 0.25f);
+    CHECK(count() == 40);
+
+    // Out of range, but still perceived until next refresh.
+    subject.set<opack::Position>({ 10.0f, 0.0f });
+    opack::step(world, 0.25f);
+    CHECK(count() > 0);
+    CHECK(count() < 40);
+    opack::step_n(world, 3, 0.25f);
+    CHECK(count() == 0);
+}
+
+TEST_CASE("Perception API : multi-threaded")
+{
+    const auto perceived_counts = [](const std::int32_t threads)
+    {
+        auto world = opack::create_world();
+        world.set_threads(threads);
+        opack::init<MyAgent>(world);
+        opack::init<MySense>(world).range(3.0f);
+        opack::add_sense<MySense, MyAgent>(world);
+        std::vector<opack::Entity> agents;
+        for (int i = 0; i < 200; i++)
+            agents.push_back(opack::spawn<MyAgent>(world).set<opack::Position>({ static_cast<float>(i % 20), static_cast<float>(i / 20) }));
+        opack::step(world);
+
+        std::vector<std::size_t> counts;
+        for (auto agent : agents)
+            counts.push_back(opack::perception(agent).subjects<MySense>().size());
+        return counts;
+    };
+
+    const auto counts = perceived_counts(1);
+    CHECK(counts.front() == 10);
+    CHECK(perceived_counts(4) == counts);
+}
+
+OPACK_SUB_PREFAB(MySubSense, MySense);
+
+TEST_CASE("Perception API : perceivables")
+{
+    auto world = opack::create_world();
+    opack::init<MyAgent>(world);
+    opack::init<MySense>(world);
+    opack::init<MySubSense>(world);
+    opack::add_sense<MySubSense, MyAgent>(world);
+    opack::perceive<MySense, Test>(world);
+    opack::perceive<MySubSense, R>(world);
+
+    CHECK(opack::entity<MySense>(world).has<opack::Sense, Test>());
+    CHECK(opack::internal::perceivable<Test>(opack::entity<MySense>(world)));
+    CHECK(!opack::internal::perceivable<R>(opack::entity<MySense>(world)));
+    CHECK(opack::internal::perceivable<Test>(opack::entity<MySubSense>(world)));
+    CHECK(opack::internal::perceivable<R>(opack::entity<MySubSense>(world)));
+    CHECK(!opack::internal::perceivable<B>(opack::entity<MySubSense>(world)));
+
+    // Declared by base after sub sense.
+    opack::perceive<MySense, B>(world);
+    CHECK(opack::internal::perceivable<B>(opack::entity<MySubSense>(world)));
+    CHECK(opack::internal::perceivable_senses<B>(world) == opack::internal::sense_bit<MySubSense>(opack::entity<MyAgent>(world)));
+    CHECK(!opack::internal::perceivable<R>(opack::entity<MySense>(world)));
+
+    auto e1 = opack::spawn<MyAgent>(world);
+    auto e2 = opack::spawn<MyAgent>(world).set<Test>({ 2.0 });
+    auto e3 = opack::spawn<MyAgent>(world);
+    e2.add<R>(e3);
+    opack::perceive<MySubSense>(e1, e2);
+    opack::perceive<MySubSense>(e1, e3);
+    auto p = opack::perception(e1);
+    CHECK(p.perceive<MySubSense, Test>(e2));
+    CHECK(p.perceive<MySubSense, R>(e2, e3));
+    CHECK(p.value<MySubSense, Test>(e2)->value == 2.0);
+}
+
+TEST_CASE("Perception API : visitors")
+{
+    auto world = opack::create_world();
+    opack::init<MyAgent>(world);
+    opack::init<MySense>(world);
+    opack::init<MyOtherSense>(world);
+    opack::add_sense<MySense, MyAgent>(world);
+    opack::add_sense<MyOtherSense, MyAgent>(world);
+    auto e1 = opack::spawn<MyAgent>(world, "e1");
+    auto e2 = opack::spawn<MyAgent>(world, "e2").set<Test>({ 2.0 });
+    auto e3 = opack::spawn<MyAgent>(world, "e3").add<B>();
+    opack::perceive<MySense>(e1, e2);
+    opack::perceive<MySense>(e1, e3);
+    opack::perceive<MyOtherSense>(e1, e2);
+    auto p = opack::perception(e1);
+
+    const auto check = [&]()
+    {
+        float sum{ 0.0f };
+        p.each<Test>([&](opack::Entity subject, const Test* value) { CHECK(subject == e2); sum += value->value; });
+        CHECK(sum == 4.0f);
+
+        std::size_t count{ 0 };
+        p.each<MyAgent>(std::function<void(opack::Entity)>([&](opack::Entity) { ++count; }));
+        CHECK(count == 3);
+
+        count = 0;
+        p.each<B>([&](opack::Entity subject, const B* value) { CHECK(subject == e3); CHECK(value == nullptr); ++count; });
+        CHECK(count == 1);
+
+        count = 0;
+        p.each_chunk([&](opack::Entity sense, std::span<const flecs::entity_t> subjects)
+            {
+                CHECK((sense == opack::entity<MySense>(world) || sense == opack::entity<MyOtherSense>(world)));
+                count += subjects.size();
+            });
+        CHECK(count == 3);
+    };
+
+    SUBCASE("Rules") { check(); }
+    SUBCASE("Cache")
+    {
+        opack::step(world);
+        check();
+    }
+}
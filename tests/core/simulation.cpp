@@ -86,3 +86,55 @@ TEST_CASE("Simulation API")
         }
     }
 }
+
+TEST_CASE("Simulation API : timers")
+{
+    opack::World world = opack::create_world();
+    auto delayed = world.entity().set<opack::Delay>({ 2.0f });
+    auto timed = world.entity().set<opack::Timer>({ 1.0f });
+    auto ticking = world.entity().set<opack::TickTimeout>({ 3 });
+    auto timing = world.entity().set<opack::TimeTimeout>({ 2.5f });
+
+    opack::step(world, 1.0f);
+    CHECK(delayed.has<opack::Delay>());
+    CHECK(!timed.has<opack::Timer>());
+    CHECK(ticking.is_alive());
+    CHECK(timing.is_alive());
+
+    MESSAGE("Setting again reschedules");
+    delayed.set<opack::Delay>({ 2.0f });
+    opack::step(world, 1.0f);
+    CHECK(delayed.has<opack::Delay>());
+    CHECK(timing.is_alive());
+
+    opack::step(world, 1.0f);
+    CHECK(!delayed.has<opack::Delay>());
+    CHECK(!ticking.is_alive());
+    CHECK(!timing.is_alive());
+
+    MESSAGE("Removed components are not expired again");
+    timed.set<opack::Timer>({ 1.0f });
+    timed.remove<opack::Timer>();
+    opack::step(world, 0.5f);
+    timed.set<opack::Timer>({ 1.0f });
+    opack::step(world, 0.5f);
+    CHECK(timed.has<opack::Timer>());
+    opack::step(world, 0.5f);
+    CHECK(!timed.has<opack::Timer>());
+
+    MESSAGE("Components set without a value are scheduled with their default value");
+    auto defaulted = world.entity().set<opack::Delay>({});
+    CHECK(opack::remaining_time<opack::Delay>(defaulted) == doctest::Approx(1.0f));
+    opack::step(world, 0.5f);
+    CHECK(defaulted.get<opack::Delay>()->value == 1.0f);
+    CHECK(opack::remaining_time<opack::Delay>(defaulted) == doctest::Approx(0.5f));
+    opack::step(world, 0.5f);
+    CHECK(!defaulted.has<opack::Delay>());
+    CHECK(opack::remaining_time<opack::Delay>(defaulted) == 0.0f);
+
+    MESSAGE("Added components are not scheduled");
+    auto added = world.entity().add<opack::Timer>();
+    opack::step(world, 2.0f);
+    CHECK(added.has<opack::Timer>());
+    CHECK(opack::remaining_time<opack::Timer>(added) == 0.0f);
+}
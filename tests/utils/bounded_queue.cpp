@@ -0,0 +1,52 @@
+#include <doctest/doctest.h>
+#include <opack/utils/bounded_queue.hpp>
+
+TEST_CASE("Bounded queue")
+{
+    auto q = bounded_queue<int>(3);
+    CHECK(q.empty());
+    CHECK(q.capacity() == 3);
+
+    CHECK(q.push(1));
+    CHECK(q.push(2));
+    CHECK(q.push(3));
+    CHECK(q.full());
+    CHECK(!q.push(4));
+    CHECK(q.size() == 3);
+    CHECK(q.front() == 1);
+    CHECK(q[2] == 3);
+
+    SUBCASE("Pop")
+    {
+        q.pop();
+        CHECK(q.front() == 2);
+        CHECK(q.push(4));
+        CHECK(q[0] == 2);
+        CHECK(q[1] == 3);
+        CHECK(q[2] == 4);
+        q.pop();
+        q.pop();
+        CHECK(q.front() == 4);
+        q.pop();
+        CHECK(q.empty());
+    }
+
+    SUBCASE("Wrap around")
+    {
+        for (int i = 4; i < 100; ++i)
+        {
+            q.pop();
+            CHECK(q.push(i));
+            CHECK(q.front() == i - 2);
+            CHECK(q[2] == i);
+        }
+    }
+
+    SUBCASE("Clear")
+    {
+        q.clear();
+        CHECK(q.empty());
+        CHECK(q.push(5));
+        CHECK(q.front() == 5);
+    }
+}
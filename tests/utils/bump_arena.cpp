@@ -0,0 +1,45 @@
+#include <doctest/doctest.h>
+#include <cstdint>
+#include <opack/utils/bump_arena.hpp>
+
+TEST_CASE("Bump arena")
+{
+    auto arena = bump_arena(64);
+    CHECK(arena.capacity() == 0);
+
+    auto a = arena.create<std::uint8_t>(std::uint8_t{ 1 });
+    auto b = arena.create<double>(2.0);
+    CHECK(*a == 1);
+    CHECK(*b == 2.0);
+    CHECK(reinterpret_cast<std::uintptr_t>(b) % alignof(double) == 0);
+    CHECK(arena.capacity() == 64);
+
+    SUBCASE("New blocks when full")
+    {
+        for (int i = 0; i < 100; ++i)
+            CHECK(*arena.create<int>(i) == i);
+        CHECK(*a == 1);
+        CHECK(*b == 2.0);
+        CHECK(arena.capacity() > 64);
+    }
+
+    SUBCASE("Values bigger than blocks")
+    {
+        struct Big { char data[200]; };
+        auto big = arena.create<Big>();
+        CHECK(big != nullptr);
+        CHECK(arena.capacity() >= 64 + 200);
+    }
+
+    SUBCASE("Reset keeps blocks")
+    {
+        for (int i = 0; i < 100; ++i)
+            arena.create<int>(i);
+        const auto capacity = arena.capacity();
+        arena.reset();
+        CHECK(arena.used() == 0);
+        for (int i = 0; i < 100; ++i)
+            CHECK(*arena.create<int>(i) == i);
+        CHECK(arena.capacity() == capacity);
+    }
+}
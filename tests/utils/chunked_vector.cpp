@@ -0,0 +1,48 @@
+#include <doctest/doctest.h>
+#include <opack/utils/chunked_vector.hpp>
+
+TEST_CASE("Chunked vector")
+{
+    auto v = chunked_vector<int, 4>();
+    CHECK(v.empty());
+
+    for (int i = 0; i < 10; ++i)
+        v.push_back(i);
+    CHECK(v.size() == 10);
+    CHECK(v[0] == 0);
+    CHECK(v[3] == 3);
+    CHECK(v[4] == 4);
+    CHECK(v[9] == 9);
+
+    SUBCASE("References stay valid")
+    {
+        const int* first = &v[0];
+        for (int i = 10; i < 100; ++i)
+            v.push_back(i);
+        CHECK(first == &v[0]);
+        CHECK(v[99] == 99);
+    }
+
+    SUBCASE("Chunks")
+    {
+        std::size_t chunks{ 0 };
+        int expected{ 0 };
+        v.for_each_chunk([&](std::span<const int> values)
+            {
+                CHECK(values.size() == (chunks < 2 ? 4 : 2));
+                for (const auto value : values)
+                    CHECK(value == expected++);
+                ++chunks;
+            });
+        CHECK(chunks == 3);
+        CHECK(expected == 10);
+    }
+
+    SUBCASE("Clear")
+    {
+        v.clear();
+        CHECK(v.empty());
+        v.push_back(5);
+        CHECK(v[0] == 5);
+    }
+}
@@ -0,0 +1,48 @@
+#include <doctest/doctest.h>
+#include <opack/utils/occupancy_grid.hpp>
+
+TEST_CASE("Occupancy grid")
+{
+    auto grid = occupancy_grid(10, 10);
+    grid.set(5, 5, true);
+    CHECK(grid.opaque(5, 5));
+    CHECK(!grid.opaque(4, 5));
+    CHECK(!grid.opaque(-1, 5));
+    CHECK(!grid.opaque(5, 10));
+
+    SUBCASE("Straight lines")
+    {
+        CHECK(!grid.visible(4.5f, 5.5f, 6.5f, 5.5f));
+        CHECK(!grid.visible(6.5f, 5.5f, 4.5f, 5.5f));
+        CHECK(!grid.visible(5.5f, 2.5f, 5.5f, 8.5f));
+        CHECK(grid.visible(4.5f, 4.5f, 6.5f, 4.5f));
+        CHECK(grid.visible(0.5f, 0.5f, 0.5f, 9.5f));
+    }
+
+    SUBCASE("Diagonals")
+    {
+        CHECK(!grid.visible(3.5f, 3.5f, 7.5f, 7.5f));
+        CHECK(!grid.visible(7.5f, 3.5f, 3.5f, 7.5f));
+        CHECK(grid.visible(3.5f, 4.5f, 7.5f, 8.5f));
+        CHECK(!grid.visible(2.5f, 4.2f, 8.5f, 6.2f));
+    }
+
+    SUBCASE("Ends are excluded")
+    {
+        CHECK(grid.visible(5.5f, 5.5f, 8.5f, 5.5f));
+        CHECK(grid.visible(2.5f, 5.5f, 5.5f, 5.5f));
+        CHECK(grid.visible(5.5f, 5.5f, 5.2f, 5.7f));
+    }
+
+    SUBCASE("Outside")
+    {
+        CHECK(grid.visible(-5.5f, -5.5f, -1.5f, 20.5f));
+        CHECK(!grid.visible(-5.5f, 5.5f, 20.5f, 5.5f));
+    }
+
+    SUBCASE("Clear")
+    {
+        grid.clear();
+        CHECK(grid.visible(4.5f, 5.5f, 6.5f, 5.5f));
+    }
+}
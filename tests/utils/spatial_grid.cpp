@@ -0,0 +1,62 @@
+#include <doctest/doctest.h>
+#include <opack/utils/spatial_grid.hpp>
+#include <algorithm>
+
+template<typename T>
+std::vector<T> query(const spatial_grid<T>& grid, float x, float y, float radius)
+{
+    std::vector<T> result;
+    grid.query(x, y, radius, [&result](const T& value) { result.push_back(value); });
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+TEST_CASE("Spatial grid")
+{
+    auto grid = spatial_grid<int>(10.0f);
+    grid.update(1, 0.0f, 0.0f);
+    grid.update(2, 5.0f, 5.0f);
+    grid.update(3, 25.0f, 0.0f);
+    grid.update(4, -12.0f, -3.0f);
+    CHECK(grid.size() == 4);
+    CHECK(grid.contains(3));
+    CHECK(!grid.contains(5));
+
+    SUBCASE("Query")
+    {
+        CHECK(query(grid, 0.0f, 0.0f, 1.0f) == std::vector{1});
+        CHECK(query(grid, 0.0f, 0.0f, 10.0f) == std::vector{1, 2});
+        CHECK(query(grid, 0.0f, 0.0f, 25.0f) == std::vector{1, 2, 3, 4});
+        CHECK(query(grid, -10.0f, 0.0f, 5.0f) == std::vector{4});
+        CHECK(query(grid, 100.0f, 100.0f, 5.0f).empty());
+    }
+
+    SUBCASE("Update")
+    {
+        grid.update(1, 1.0f, 1.0f);   // Same cell
+        CHECK(query(grid, 1.0f, 1.0f, 0.5f) == std::vector{1});
+        grid.update(1, 24.0f, 0.0f);  // Other cell
+        CHECK(query(grid, 0.0f, 0.0f, 1.0f).empty());
+        CHECK(query(grid, 25.0f, 0.0f, 2.0f) == std::vector{1, 3});
+        CHECK(grid.size() == 4);
+    }
+
+    SUBCASE("Erase")
+    {
+        grid.erase(2);
+        grid.erase(5);
+        CHECK(grid.size() == 3);
+        CHECK(query(grid, 0.0f, 0.0f, 10.0f) == std::vector{1});
+        grid.update(2, 5.0f, 5.0f);
+        CHECK(query(grid, 0.0f, 0.0f, 10.0f) == std::vector{1, 2});
+    }
+
+    SUBCASE("Rebuild")
+    {
+        grid.rebuild(1.0f);
+        CHECK(grid.cell_size() == 1.0f);
+        CHECK(grid.size() == 4);
+        CHECK(query(grid, 0.0f, 0.0f, 10.0f) == std::vector{1, 2});
+        CHECK(query(grid, 0.0f, 0.0f, 25.0f) == std::vector{1, 2, 3, 4});
+    }
+}
@@ -0,0 +1,99 @@
+#include <doctest/doctest.h>
+#include <opack/utils/timer_wheel.hpp>
+#include <algorithm>
+#include <random>
+#include <tuple>
+
+TEST_CASE("Timer wheel")
+{
+    auto wheel = timer_wheel<int>();
+    std::vector<int> expired;
+    const auto advance = [&](std::uint64_t to)
+    {
+        expired.clear();
+        wheel.advance(to, [&expired](int value) { expired.push_back(value); });
+        return expired;
+    };
+
+    SUBCASE("Expiration")
+    {
+        wheel.schedule(1, 10);
+        wheel.schedule(2, 10);
+        wheel.schedule(3, 100);
+        wheel.schedule(4, 5000);
+        CHECK(wheel.size() == 4);
+        CHECK(advance(9).empty());
+        CHECK(advance(10) == std::vector{ 1, 2 });
+        CHECK(advance(99).empty());
+        CHECK(advance(100) == std::vector{ 3 });
+        CHECK(advance(4999).empty());
+        CHECK(advance(6000) == std::vector{ 4 });
+        CHECK(wheel.empty());
+        CHECK(wheel.now() == 6000);
+    }
+
+    SUBCASE("Already reached")
+    {
+        advance(50);
+        wheel.schedule(1, 20);
+        wheel.schedule(2, 50);
+        CHECK(advance(50) == std::vector{ 1, 2 });
+    }
+
+    SUBCASE("Order")
+    {
+        wheel.schedule(1, 300);
+        wheel.schedule(2, 70);
+        wheel.schedule(3, 64);
+        CHECK(advance(1000) == std::vector{ 3, 2, 1 });
+    }
+
+    SUBCASE("Overflow")
+    {
+        const std::uint64_t far = std::uint64_t{ 1 } << 30;
+        wheel.schedule(1, far);
+        wheel.schedule(2, far + 1);
+        CHECK(advance(far - 1).empty());
+        CHECK(advance(far) == std::vector{ 1 });
+        CHECK(advance(far + 1) == std::vector{ 2 });
+    }
+
+    SUBCASE("Scheduled while expiring")
+    {
+        wheel.schedule(1, 10);
+        wheel.advance(10, [&](int value) { wheel.schedule(value + 1, 20); wheel.schedule(value + 2, 5); });
+        CHECK(wheel.size() == 2);
+        CHECK(advance(20) == std::vector{ 3, 2 });
+    }
+
+    SUBCASE("Random")
+    {
+        std::mt19937 generator{ 42 };
+        std::uniform_int_distribution<std::uint64_t> deadlines{ 0, 1 << 20 };
+        std::vector<std::pair<std::uint64_t, int>> expected;
+        for (int i = 0; i < 1000; ++i)
+        {
+            const auto deadline = deadlines(generator);
+            wheel.schedule(i, deadline);
+            expected.emplace_back(deadline, i);
+        }
+        // Each value must expire during the first advance reaching its deadline.
+        std::uint64_t previous{ 0 };
+        std::uint64_t now{ 0 };
+        std::vector<std::tuple<std::uint64_t, std::uint64_t, int>> actual;
+        while (!wheel.empty())
+        {
+            previous = now;
+            now += 1 + deadlines(generator) % 5000;
+            wheel.advance(now, [&](int value) { actual.emplace_back(previous, now, value); });
+        }
+        for (const auto& [deadline, value] : expected)
+        {
+            const auto it = std::find_if(actual.begin(), actual.end(), [value](const auto& a) { return std::get<2>(a) == value; });
+            REQUIRE(it != actual.end());
+            CHECK(deadline <= std::get<1>(*it));
+            CHECK((deadline > std::get<0>(*it) || std::get<0>(*it) == 0));
+        }
+        CHECK(actual.size() == expected.size());
+    }
+}
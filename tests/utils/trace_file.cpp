@@ -0,0 +1,61 @@
+#include <doctest/doctest.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <opack/utils/trace_file.hpp>
+
+namespace
+{
+    struct Record
+    {
+        std::uint64_t id;
+        float value;
+        std::uint32_t flags;
+    };
+}
+
+TEST_CASE("Trace file")
+{
+    const auto path = std::filesystem::temp_directory_path() / "opack_trace_file_test.bin";
+
+    SUBCASE("Records are read back in order")
+    {
+        {
+            // Small buffers, so that several hand overs happen.
+            trace_writer<Record> writer(path, 4);
+            for (std::uint64_t i = 0; i < 1000; ++i)
+                writer.push({ i, static_cast<float>(i) / 2.0f, static_cast<std::uint32_t>(i % 3) });
+        }
+        trace_reader<Record> reader(path);
+        REQUIRE(reader.size() == 1000);
+        for (std::uint64_t i = 0; i < 1000; ++i)
+        {
+            CHECK(reader[i].id == i);
+            CHECK(reader[i].value == static_cast<float>(i) / 2.0f);
+            CHECK(reader[i].flags == i % 3);
+        }
+    }
+
+    SUBCASE("Empty trace")
+    {
+        trace_writer<Record> writer(path);
+        writer.close();
+        trace_reader<Record> reader(path);
+        CHECK(reader.size() == 0);
+        CHECK(reader.records().empty());
+    }
+
+    SUBCASE("Other record type is rejected")
+    {
+        trace_writer<std::uint32_t>(path).push(1);
+        CHECK_THROWS_AS(trace_reader<Record>(path), std::runtime_error);
+    }
+
+    SUBCASE("Other file is rejected")
+    {
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << "not a trace file, but long enough";
+        CHECK_THROWS_AS(trace_reader<Record>(path), std::runtime_error);
+    }
+
+    std::filesystem::remove(path);
+}